@@ -7,39 +7,79 @@ uniform sampler2D scene;
 uniform vec2      offsets[9];
 uniform int       edge_kernel[9];
 uniform float     blur_kernel[9];
+uniform vec2      uvScale; // part of the scene texture covered by the (possibly reduced) scene
 
-uniform bool chaos;
-uniform bool confuse;
-uniform bool shake;
+// effects are compiled in as permutations (CHAOS, CONFUSE, SHAKE, FXAA) instead of runtime branches
+
+// samples the scene in [0, 1] scene coordinates, wrapping like GL_REPEAT would on a full size scene
+vec4 fetchScene(vec2 uv)
+{
+    vec2 halfTexel = 0.5 / vec2(textureSize(scene, 0));
+    return texture(scene, min(fract(uv) * uvScale, uvScale - halfTexel));
+}
+
+#if defined(FXAA)
+const float FXAA_SPAN_MAX   = 8.0;
+const float FXAA_REDUCE_MUL = 1.0 / 8.0;
+const float FXAA_REDUCE_MIN = 1.0 / 128.0;
+
+float luma(vec3 rgb)
+{
+    return dot(rgb, vec3(0.299, 0.587, 0.114));
+}
+
+// blends along the local edge direction found from the luma of the diagonal neighbours
+vec3 sampleScene(vec2 uv)
+{
+    vec2 texel = 1.0 / (vec2(textureSize(scene, 0)) * uvScale);
+    vec3 rgbM  = fetchScene(uv).rgb;
+    float lumaNW = luma(fetchScene(uv + vec2(-1.0, -1.0) * texel).rgb);
+    float lumaNE = luma(fetchScene(uv + vec2( 1.0, -1.0) * texel).rgb);
+    float lumaSW = luma(fetchScene(uv + vec2(-1.0,  1.0) * texel).rgb);
+    float lumaSE = luma(fetchScene(uv + vec2( 1.0,  1.0) * texel).rgb);
+    float lumaM  = luma(rgbM);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * FXAA_REDUCE_MUL, FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel;
+
+    vec3 rgbA = 0.5 * (fetchScene(uv + dir * (1.0 / 3.0 - 0.5)).rgb + fetchScene(uv + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (fetchScene(uv - dir * 0.5).rgb + fetchScene(uv + dir * 0.5).rgb);
+    float lumaB = luma(rgbB);
+    return (lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB;
+}
+#else
+vec3 sampleScene(vec2 uv)
+{
+    return fetchScene(uv).rgb;
+}
+#endif
 
 void main()
 {
     color = vec4(0.0f);
-    vec3 sample[9];
+#if defined(CHAOS) || (defined(SHAKE) && !defined(CONFUSE))
     // sample from texture offsets if using convolution matrix
-    if(chaos || shake)
-        for(int i = 0; i < 9; i++)
-            sample[i] = vec3(texture(scene, TexCoords.st + offsets[i]));
+    vec3 sample[9];
+    for(int i = 0; i < 9; i++)
+        sample[i] = vec3(fetchScene(TexCoords.st + offsets[i]));
+#endif
 
     // process effects
-    if (chaos)
-    {           
-        for(int i = 0; i < 9; i++)
-            color += vec4(sample[i] * edge_kernel[i], 0.0f);
-        color.a = 1.0f;
-    }
-    else if (confuse)
-    {
-        color = vec4(1.0 - texture(scene, TexCoords).rgb, 1.0);
-    }
-    else if (shake)
-    {
-        for(int i = 0; i < 9; i++)
-            color += vec4(sample[i] * blur_kernel[i], 0.0f);
-        color.a = 1.0f;
-    }
-    else
-    {
-        color = texture(scene, TexCoords);
-    }
+#if defined(CHAOS)
+    for(int i = 0; i < 9; i++)
+        color += vec4(sample[i] * edge_kernel[i], 0.0f);
+    color.a = 1.0f;
+#elif defined(CONFUSE)
+    color = vec4(1.0 - sampleScene(TexCoords), 1.0);
+#elif defined(SHAKE)
+    for(int i = 0; i < 9; i++)
+        color += vec4(sample[i] * blur_kernel[i], 0.0f);
+    color.a = 1.0f;
+#else
+    color = vec4(sampleScene(TexCoords), 1.0);
+#endif
 }
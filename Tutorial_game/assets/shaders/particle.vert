@@ -1,10 +1,11 @@
 #version 330 core
 
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec2 offset; // per instance: particle position
+layout (location = 2) in vec4 color;  // per instance: particle color
 
 uniform mat4 projection;
-uniform vec2 offset;
-uniform vec4 color;
+uniform vec4 texRect; // <vec2 uv offset, vec2 uv scale> of the sprite in its atlas
 
 out vec2 TexCoords;
 out vec4 ParticleColor;
@@ -12,7 +13,7 @@ out vec4 ParticleColor;
 void main()
 {
     const float scale = 10.0f;
-    TexCoords = vertex.zw;
+    TexCoords = texRect.xy + vertex.zw * texRect.zw;
     ParticleColor = color;
     gl_Position = projection * vec4((vertex.xy * scale) + offset, 0.0, 1.0);
 }
@@ -0,0 +1,30 @@
+#version 330 core
+
+// particle state as stored in the GPU particle buffers (see struct Particle)
+layout (location = 0) in vec2  position;
+layout (location = 1) in vec2  velocity;
+layout (location = 2) in vec4  color;
+layout (location = 3) in float life;
+
+// captured with transform feedback into the other particle buffer
+out vec2  outPosition;
+out vec2  outVelocity;
+out vec4  outColor;
+out float outLife;
+
+uniform float dt;
+
+void main()
+{
+    outPosition = position;
+    outVelocity = velocity;
+    outColor = color;
+    outLife = life - dt; // reduce life
+    if (outLife > 0.0)
+    {   // particle is alive, thus update
+        outPosition += velocity * dt;
+        outColor.a -= dt * 2.5;
+    }
+    else
+        outColor.a = 0.0; // dead particles are still drawn, keep them invisible
+}
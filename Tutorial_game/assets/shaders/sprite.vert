@@ -1,14 +1,24 @@
 #version 330 core
 
-layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 0) in vec4 vertex;        // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 rect;          // per instance: <vec2 position, vec2 size>
+layout (location = 2) in vec4 colorRotation; // per instance: <vec3 color, float rotation>
+layout (location = 3) in vec4 texRect;       // per instance: <vec2 uv offset, vec2 uv scale>
 
 out vec2 TexCoords;
+out vec3 SpriteColor;
 
-uniform mat4 model;
 uniform mat4 projection;
 
 void main()
 {
-    TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = texRect.xy + vertex.zw * texRect.zw;
+    SpriteColor = colorRotation.rgb;
+    // scale, then rotate around the center of the quad, then translate
+    vec2 local = (vertex.xy - 0.5) * rect.zw;
+    float angle = radians(colorRotation.w);
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + 0.5 * rect.zw + rect.xy;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
 }
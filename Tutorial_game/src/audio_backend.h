@@ -0,0 +1,39 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#include <string>
+
+
+// The sound interface the game plays its effects through. The
+// AudioManager implements it with miniaudio; NullAudio discards
+// everything for headless runs.
+class AudioBackend
+{
+public:
+    virtual ~AudioBackend() { }
+
+    virtual void loadSound(const char* path, std::string name) = 0;
+    virtual void play(std::string name) = 0;
+    virtual void setLooping(std::string name, bool loop_state) = 0;
+};
+
+// Audio backend that plays nothing, only counts the requests
+class NullAudio : public AudioBackend
+{
+public:
+    unsigned int Played = 0;
+
+    void loadSound(const char* /*path*/, std::string /*name*/) override { }
+    void play(std::string /*name*/) override { this->Played++; }
+    void setLooping(std::string /*name*/, bool /*loop_state*/) override { }
+};
+
+#endif
@@ -6,16 +6,18 @@
 
 #include <miniaudio.h>
 
+#include "audio_backend.h"
 
-class AudioManager
+
+class AudioManager : public AudioBackend
 {
 public:
     AudioManager();
     ~AudioManager();
 
-    void loadSound(const char* path, std::string name);
-    void play(std::string name);
-    void setLooping(std::string name, bool loop_state);
+    void loadSound(const char* path, std::string name) override;
+    void play(std::string name) override;
+    void setLooping(std::string name, bool loop_state) override;
 
 private:
     ma_engine engine;
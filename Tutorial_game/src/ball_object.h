@@ -9,11 +9,10 @@
 #ifndef BALLOBJECT_H
 #define BALLOBJECT_H
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "game_object.h"
-#include "texture.h"
+#include "sprite.h"
 
 
 // BallObject holds the state of the Ball object inheriting
@@ -31,9 +30,7 @@ public:
     
     // constructor(s)
     BallObject();
-    BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, Texture2D sprite);
-    // moves the ball, keeping it constrained within the window bounds (except bottom edge); returns new position
-    glm::vec2 Move(float dt, unsigned int window_width);
+    BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, TextureRegion sprite);
     // resets the ball to original state with given position and velocity
     void      Reset(glm::vec2 position, glm::vec2 velocity);
 };
@@ -0,0 +1,118 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "brick_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+BrickGrid::BrickGrid()
+    : cellSize(1.0f), columns(0), rows(0)
+{
+
+}
+
+void BrickGrid::Build(glm::vec2 cellSize, unsigned int columns, unsigned int rows, const std::vector<glm::vec2> &positions, const std::vector<glm::vec2> &sizes)
+{
+    this->cellSize = cellSize;
+    this->columns = columns;
+    this->rows = rows;
+    // degenerate layouts (e.g. more rows than pixels) fall back to a single cell holding everything
+    if (cellSize.x <= 0.0f || cellSize.y <= 0.0f)
+    {
+        this->cellSize = glm::vec2(std::numeric_limits<float>::max());
+        this->columns = this->rows = 1;
+    }
+    columns = this->columns;
+    rows = this->rows;
+    this->cellStart.assign(columns * rows + 1, 0);
+    this->cellCount.assign(columns * rows, 0);
+    // 1. count the bricks of every cell
+    glm::ivec2 first, last;
+    for (unsigned int i = 0; i < positions.size(); ++i)
+        if (this->brickCells(positions[i], sizes[i], first, last))
+            for (int y = first.y; y <= last.y; ++y)
+                for (int x = first.x; x <= last.x; ++x)
+                    this->cellCount[y * columns + x]++;
+    // 2. lay the cell lists out back to back
+    for (unsigned int cell = 0; cell < columns * rows; ++cell)
+        this->cellStart[cell + 1] = this->cellStart[cell] + this->cellCount[cell];
+    // 3. fill them in brick order, so every list is sorted
+    this->entries.assign(this->cellStart.back(), 0);
+    std::fill(this->cellCount.begin(), this->cellCount.end(), 0);
+    for (unsigned int i = 0; i < positions.size(); ++i)
+        if (this->brickCells(positions[i], sizes[i], first, last))
+            for (int y = first.y; y <= last.y; ++y)
+                for (int x = first.x; x <= last.x; ++x)
+                {
+                    const unsigned int cell = y * columns + x;
+                    this->entries[this->cellStart[cell] + this->cellCount[cell]++] = i;
+                }
+}
+
+void BrickGrid::Remove(unsigned int brick, glm::vec2 position, glm::vec2 size)
+{
+    glm::ivec2 first, last;
+    if (!this->brickCells(position, size, first, last))
+        return;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+        {
+            const unsigned int cell = y * this->columns + x;
+            unsigned int *list = &this->entries[this->cellStart[cell]];
+            unsigned int *end = list + this->cellCount[cell];
+            unsigned int *entry = std::find(list, end, brick);
+            if (entry == end)
+                continue;
+            // keep the list sorted
+            std::copy(entry + 1, end, entry);
+            this->cellCount[cell]--;
+        }
+}
+
+void BrickGrid::Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const
+{
+    bricks.clear();
+    glm::ivec2 first, last;
+    if (!this->cellRange(min, max, first, last))
+        return;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+        {
+            const unsigned int cell = y * this->columns + x;
+            const unsigned int *list = &this->entries[this->cellStart[cell]];
+            bricks.insert(bricks.end(), list, list + this->cellCount[cell]);
+        }
+    // bricks spanning several cells are listed more than once
+    if (first != last)
+    {
+        std::sort(bricks.begin(), bricks.end());
+        bricks.erase(std::unique(bricks.begin(), bricks.end()), bricks.end());
+    }
+}
+
+bool BrickGrid::cellRange(glm::vec2 min, glm::vec2 max, glm::ivec2 &first, glm::ivec2 &last) const
+{
+    if (this->columns == 0 || this->rows == 0)
+        return false;
+    const glm::vec2 from = glm::floor(min / this->cellSize), to = glm::floor(max / this->cellSize);
+    const glm::vec2 limit(this->columns - 1, this->rows - 1);
+    if (to.x < 0.0f || to.y < 0.0f || from.x > limit.x || from.y > limit.y)
+        return false;
+    first = glm::ivec2(glm::max(from, glm::vec2(0.0f)));
+    last = glm::ivec2(glm::min(to, limit));
+    return true;
+}
+
+bool BrickGrid::brickCells(glm::vec2 position, glm::vec2 size, glm::ivec2 &first, glm::ivec2 &last) const
+{
+    const glm::vec2 inset = glm::min(this->cellSize, size) * 0.001f;
+    return this->cellRange(position + inset, position + size - inset, first, last);
+}
@@ -0,0 +1,47 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef BRICK_GRID_H
+#define BRICK_GRID_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+// BrickGrid is a uniform grid over the bricks of a level, used as the
+// collision broadphase: a query only visits the cells an area overlaps,
+// so its cost depends on the size of the area and not on the number of
+// bricks. Each brick is listed in every cell its bounds overlap (with
+// grid aligned levels that is exactly one). The cell lists are stored
+// back to back in a single array; removing a brick shrinks its cells'
+// lists in place.
+class BrickGrid
+{
+public:
+    // constructor (an empty grid)
+    BrickGrid();
+    // (re)builds the grid of columns x rows cells of the given size, its origin at (0, 0)
+    void Build(glm::vec2 cellSize, unsigned int columns, unsigned int rows, const std::vector<glm::vec2> &positions, const std::vector<glm::vec2> &sizes);
+    // removes the brick with the given bounds from all its cells
+    void Remove(unsigned int brick, glm::vec2 position, glm::vec2 size);
+    // replaces the contents of bricks with those listed in the cells the area overlaps, in ascending order
+    void Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const;
+private:
+    glm::vec2                 cellSize;
+    unsigned int              columns, rows;
+    std::vector<unsigned int> cellStart; // first entry of each cell
+    std::vector<unsigned int> cellCount; // bricks still listed in each cell
+    std::vector<unsigned int> entries;
+    // the cells an area overlaps (inclusive); false if it misses the grid
+    bool cellRange(glm::vec2 min, glm::vec2 max, glm::ivec2 &first, glm::ivec2 &last) const;
+    // the cells of a brick; its edges lie on cell borders, so they are moved inwards a little
+    bool brickCells(glm::vec2 position, glm::vec2 size, glm::ivec2 &first, glm::ivec2 &last) const;
+};
+
+#endif
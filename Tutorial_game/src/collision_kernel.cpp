@@ -0,0 +1,200 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "collision_kernel.h"
+
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define COLLISION_KERNEL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define COLLISION_KERNEL_SSE2
+#endif
+
+
+void BoxBatch::Clear()
+{
+    this->MinX.clear();
+    this->MinY.clear();
+    this->MaxX.clear();
+    this->MaxY.clear();
+    this->Count = 0;
+}
+
+unsigned int BoxBatch::Add(glm::vec2 position, glm::vec2 size)
+{
+    if (this->Count == this->MinX.size())
+    {
+        // pad with inverted boxes: their closest point is infinitely far from everything
+        this->MinX.resize(this->Count + BOX_BATCH_WIDTH, FLT_MAX);
+        this->MinY.resize(this->Count + BOX_BATCH_WIDTH, FLT_MAX);
+        this->MaxX.resize(this->Count + BOX_BATCH_WIDTH, -FLT_MAX);
+        this->MaxY.resize(this->Count + BOX_BATCH_WIDTH, -FLT_MAX);
+    }
+    this->MinX[this->Count] = position.x;
+    this->MinY[this->Count] = position.y;
+    this->MaxX[this->Count] = position.x + size.x;
+    this->MaxY[this->Count] = position.y + size.y;
+    return this->Count++;
+}
+
+
+// The operations of the kernel on a group of lanes: one float, or 4/8 in
+// a vector register. Masks are booleans, or lanes with all bits set. The
+// vector min/max/compare instructions behave like the scalar expressions
+// used here (NaNs included), so every width gives the same results.
+struct Lanes1 {
+    static constexpr unsigned int Width = 1;
+    float V;
+};
+struct Mask1 {
+    bool V;
+};
+static inline Lanes1 load(const float *values, Lanes1) { return { *values }; }
+static inline void store(float *values, Lanes1 lanes) { *values = lanes.V; }
+static inline Lanes1 splat(float value, Lanes1) { return { value }; }
+static inline Lanes1 operator+(Lanes1 a, Lanes1 b) { return { a.V + b.V }; }
+static inline Lanes1 operator-(Lanes1 a, Lanes1 b) { return { a.V - b.V }; }
+static inline Lanes1 operator*(Lanes1 a, Lanes1 b) { return { a.V * b.V }; }
+static inline Lanes1 operator/(Lanes1 a, Lanes1 b) { return { a.V / b.V }; }
+static inline Lanes1 min(Lanes1 a, Lanes1 b) { return { a.V < b.V ? a.V : b.V }; }
+static inline Lanes1 max(Lanes1 a, Lanes1 b) { return { a.V > b.V ? a.V : b.V }; }
+static inline Lanes1 sqrt(Lanes1 a) { return { std::sqrt(a.V) }; }
+static inline Mask1 lessEqual(Lanes1 a, Lanes1 b) { return { a.V <= b.V }; }
+static inline Lanes1 select(Mask1 mask, Lanes1 a, Lanes1 b) { return mask.V ? a : b; }
+static inline unsigned int bits(Mask1 mask) { return mask.V ? 1u : 0u; }
+
+#ifdef COLLISION_KERNEL_SSE2
+struct Lanes4 {
+    static constexpr unsigned int Width = 4;
+    __m128 V;
+};
+struct Mask4 {
+    __m128 V;
+};
+static inline Lanes4 load(const float *values, Lanes4) { return { _mm_loadu_ps(values) }; }
+static inline void store(float *values, Lanes4 lanes) { _mm_storeu_ps(values, lanes.V); }
+static inline Lanes4 splat(float value, Lanes4) { return { _mm_set1_ps(value) }; }
+static inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return { _mm_add_ps(a.V, b.V) }; }
+static inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return { _mm_sub_ps(a.V, b.V) }; }
+static inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return { _mm_mul_ps(a.V, b.V) }; }
+static inline Lanes4 operator/(Lanes4 a, Lanes4 b) { return { _mm_div_ps(a.V, b.V) }; }
+static inline Lanes4 min(Lanes4 a, Lanes4 b) { return { _mm_min_ps(a.V, b.V) }; }
+static inline Lanes4 max(Lanes4 a, Lanes4 b) { return { _mm_max_ps(a.V, b.V) }; }
+static inline Lanes4 sqrt(Lanes4 a) { return { _mm_sqrt_ps(a.V) }; }
+static inline Mask4 lessEqual(Lanes4 a, Lanes4 b) { return { _mm_cmple_ps(a.V, b.V) }; }
+static inline Lanes4 select(Mask4 mask, Lanes4 a, Lanes4 b) { return { _mm_or_ps(_mm_and_ps(mask.V, a.V), _mm_andnot_ps(mask.V, b.V)) }; }
+static inline unsigned int bits(Mask4 mask) { return static_cast<unsigned int>(_mm_movemask_ps(mask.V)); }
+#endif
+
+#ifdef COLLISION_KERNEL_AVX
+struct Lanes8 {
+    static constexpr unsigned int Width = 8;
+    __m256 V;
+};
+struct Mask8 {
+    __m256 V;
+};
+static inline Lanes8 load(const float *values, Lanes8) { return { _mm256_loadu_ps(values) }; }
+static inline void store(float *values, Lanes8 lanes) { _mm256_storeu_ps(values, lanes.V); }
+static inline Lanes8 splat(float value, Lanes8) { return { _mm256_set1_ps(value) }; }
+static inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return { _mm256_add_ps(a.V, b.V) }; }
+static inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return { _mm256_sub_ps(a.V, b.V) }; }
+static inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return { _mm256_mul_ps(a.V, b.V) }; }
+static inline Lanes8 operator/(Lanes8 a, Lanes8 b) { return { _mm256_div_ps(a.V, b.V) }; }
+static inline Lanes8 min(Lanes8 a, Lanes8 b) { return { _mm256_min_ps(a.V, b.V) }; }
+static inline Lanes8 max(Lanes8 a, Lanes8 b) { return { _mm256_max_ps(a.V, b.V) }; }
+static inline Lanes8 sqrt(Lanes8 a) { return { _mm256_sqrt_ps(a.V) }; }
+static inline Mask8 lessEqual(Lanes8 a, Lanes8 b) { return { _mm256_cmp_ps(a.V, b.V, _CMP_LE_OQ) }; }
+static inline Lanes8 select(Mask8 mask, Lanes8 a, Lanes8 b) { return { _mm256_blendv_ps(b.V, a.V, mask.V) }; }
+static inline unsigned int bits(Mask8 mask) { return static_cast<unsigned int>(_mm256_movemask_ps(mask.V)); }
+#endif
+
+// tests the boxes from first on, as many as fill whole groups of lanes; returns the first one left
+template <typename Lanes>
+static unsigned int collideLanes(glm::vec2 center, float radius, const BoxBatch &boxes, BoxContacts &contacts, unsigned int first, unsigned int &hits)
+{
+    const Lanes centerX = splat(center.x, Lanes()), centerY = splat(center.y, Lanes());
+    const Lanes radius2 = splat(radius * radius, Lanes());
+    const Lanes zero = splat(0.0f, Lanes()), one = splat(1.0f, Lanes()), minusOne = splat(-1.0f, Lanes());
+    const unsigned int end = static_cast<unsigned int>(boxes.MinX.size());
+    unsigned int i = first;
+    for (; i + Lanes::Width <= end; i += Lanes::Width)
+    {
+        const Lanes minX = load(&boxes.MinX[i], Lanes()), minY = load(&boxes.MinY[i], Lanes());
+        const Lanes maxX = load(&boxes.MaxX[i], Lanes()), maxY = load(&boxes.MaxY[i], Lanes());
+        // closest point of each box and the squared distance to it
+        const Lanes dx = centerX - min(max(centerX, minX), maxX);
+        const Lanes dy = centerY - min(max(centerY, minY), maxY);
+        const Lanes distance2 = dx * dx + dy * dy;
+        const unsigned int mask = bits(lessEqual(distance2, radius2));
+        // boxes are mostly missed: only groups with a hit go on to their normals
+        if (mask == 0)
+            continue;
+        contacts.HitMask[i / 32] |= mask << (i % 32); // groups never straddle words, as 32 is a multiple of every width
+        hits += std::popcount(mask);
+        // the direction from the closest point to the center
+        const Lanes distance = sqrt(distance2);
+        // or, for centers inside a box (whose division by 0 is discarded), out of the nearest face
+        const Lanes left = centerX - minX, right = maxX - centerX;
+        const Lanes bottom = centerY - minY, top = maxY - centerY;
+        const auto horizontal = lessEqual(min(left, right), min(bottom, top));
+        const Lanes faceX = select(horizontal, select(lessEqual(left, right), minusOne, one), zero);
+        const Lanes faceY = select(horizontal, zero, select(lessEqual(bottom, top), minusOne, one));
+        const auto inside = lessEqual(distance2, zero);
+        store(&contacts.NormalX[i], select(inside, faceX, dx / distance));
+        store(&contacts.NormalY[i], select(inside, faceY, dy / distance));
+    }
+    return i;
+}
+
+// sizes and clears the results for the batch
+static void prepareContacts(const BoxBatch &boxes, BoxContacts &contacts)
+{
+    const std::size_t size = boxes.MinX.size();
+    contacts.HitMask.assign((size + 31) / 32, 0u);
+    contacts.NormalX.resize(size);
+    contacts.NormalY.resize(size);
+}
+
+unsigned int CollideCircleBoxes(glm::vec2 center, float radius, const BoxBatch &boxes, BoxContacts &contacts)
+{
+    prepareContacts(boxes, contacts);
+    unsigned int hits = 0, next = 0;
+#if defined(COLLISION_KERNEL_AVX)
+    next = collideLanes<Lanes8>(center, radius, boxes, contacts, next, hits);
+#elif defined(COLLISION_KERNEL_SSE2)
+    next = collideLanes<Lanes4>(center, radius, boxes, contacts, next, hits);
+#endif
+    // whatever the vector width left over (nothing, with the padding)
+    collideLanes<Lanes1>(center, radius, boxes, contacts, next, hits);
+    return hits;
+}
+
+unsigned int CollideCircleBoxesScalar(glm::vec2 center, float radius, const BoxBatch &boxes, BoxContacts &contacts)
+{
+    prepareContacts(boxes, contacts);
+    unsigned int hits = 0;
+    collideLanes<Lanes1>(center, radius, boxes, contacts, 0, hits);
+    return hits;
+}
+
+const char *CollisionKernelName()
+{
+#if defined(COLLISION_KERNEL_AVX)
+    return "avx";
+#elif defined(COLLISION_KERNEL_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
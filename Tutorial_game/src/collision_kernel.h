@@ -0,0 +1,55 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COLLISION_KERNEL_H
+#define COLLISION_KERNEL_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Number of boxes a BoxBatch is padded to a multiple of (the widest vector the kernel uses)
+constexpr unsigned int BOX_BATCH_WIDTH = 8;
+
+// Axis aligned boxes as structure of arrays, so the kernel loads the
+// same coordinate of consecutive boxes into one register. The arrays are
+// padded with empty boxes (which nothing touches) up to a multiple of
+// BOX_BATCH_WIDTH; Count is the number of real ones.
+struct BoxBatch {
+    std::vector<float> MinX, MinY, MaxX, MaxY;
+    unsigned int       Count = 0;
+    // removes all boxes
+    void Clear();
+    // appends a box, returning its index
+    unsigned int Add(glm::vec2 position, glm::vec2 size);
+};
+
+// Result of testing one circle against a BoxBatch
+struct BoxContacts {
+    // bit (i % 32) of word (i / 32) is set if the circle touches box i
+    std::vector<std::uint32_t> HitMask;
+    // unit normal of box i at the contact, pointing at the circle (only meaningful for hits):
+    // towards the center from the closest point of the box, or out of the nearest face if the center is inside
+    std::vector<float>         NormalX, NormalY;
+    // whether the circle touches box i
+    bool Hit(unsigned int box) const { return (this->HitMask[box / 32] >> (box % 32)) & 1u; }
+};
+
+// Tests a circle against all boxes of the batch at once (touching counts,
+// as in CheckCollision). Only squared distances are compared and the
+// closest points are found with min/max instead of branches; lanes of 8
+// (AVX) or 4 (SSE2) boxes are processed together where the compiler
+// targets them. Returns the number of boxes hit.
+unsigned int CollideCircleBoxes(glm::vec2 center, float radius, const BoxBatch &boxes, BoxContacts &contacts);
+// The same one box at a time, for targets without SIMD (gives identical results)
+unsigned int CollideCircleBoxesScalar(glm::vec2 center, float radius, const BoxBatch &boxes, BoxContacts &contacts);
+// Name of the instruction set CollideCircleBoxes uses ("avx", "sse2" or "scalar")
+const char *CollisionKernelName();
+
+#endif
@@ -0,0 +1,40 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+
+
+DynamicResolution::DynamicResolution(float frameBudget)
+    : Scale(MAX_RENDER_SCALE), AverageTime(frameBudget), budget(frameBudget), cooldown(0)
+{
+
+}
+
+bool DynamicResolution::AddFrame(float frameTime)
+{
+    // smooth out single spikes
+    this->AverageTime += (frameTime - this->AverageTime) * 0.1f;
+    if (this->cooldown > 0)
+    {
+        this->cooldown--;
+        return false;
+    }
+    float scale = this->Scale;
+    if (this->AverageTime > this->budget * 0.9f)
+        scale -= RENDER_SCALE_STEP;
+    else if (this->AverageTime < this->budget * 0.7f)
+        scale += RENDER_SCALE_STEP;
+    scale = std::clamp(scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    if (scale == this->Scale)
+        return false;
+    this->Scale = scale;
+    this->cooldown = RENDER_SCALE_COOLDOWN;
+    return true;
+}
@@ -0,0 +1,41 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+
+// Bounds and step of the internal render scale
+constexpr float MIN_RENDER_SCALE  = 0.5f;
+constexpr float MAX_RENDER_SCALE  = 1.0f;
+constexpr float RENDER_SCALE_STEP = 0.05f;
+// Frames to wait after a scale change before the next one, so the
+// averaged frame time can settle on the new resolution
+constexpr unsigned int RENDER_SCALE_COOLDOWN = 30;
+
+
+// DynamicResolution picks the internal scene resolution from recent
+// frame times. The scale drops as soon as the averaged frame time
+// comes close to the frame budget and slowly climbs back when there
+// is plenty of headroom.
+class DynamicResolution
+{
+public:
+    // state
+    float Scale;
+    float AverageTime; // exponential moving average of the frame time (seconds)
+    // constructor
+    DynamicResolution(float frameBudget);
+    // adds a measured frame time (seconds); returns true if Scale changed
+    bool AddFrame(float frameTime);
+private:
+    float        budget;
+    unsigned int cooldown;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_pacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+
+FramePacer::FramePacer(PacingMode mode, unsigned int targetFps)
+    : Mode(mode), period(std::chrono::nanoseconds(1000000000LL / targetFps)), swapInterval(0), started(false),
+      frames(0), sum(0.0), sumSquares(0.0), minimum(0.0), maximum(0.0)
+{
+
+}
+
+void FramePacer::Configure()
+{
+    switch (this->Mode)
+    {
+    case PACING_VSYNC:
+        // the swap itself waits
+        this->swapInterval = 1;
+        this->period = std::chrono::nanoseconds(0);
+        break;
+    case PACING_UNCAPPED:
+        this->swapInterval = 0;
+        this->period = std::chrono::nanoseconds(0);
+        break;
+    case PACING_CAPPED:
+        this->swapInterval = 0;
+        break;
+    case PACING_ADAPTIVE:
+        if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+        {   // a negative interval lets late frames swap immediately
+            this->swapInterval = -1;
+            this->period = std::chrono::nanoseconds(0);
+        }
+        else
+        {   // emulate it: never wait for the blank, but don't outrun the display either
+            this->swapInterval = 0;
+            const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+            if (mode && mode->refreshRate > 0)
+                this->period = std::chrono::nanoseconds(1000000000LL / mode->refreshRate);
+        }
+        break;
+    }
+}
+
+int FramePacer::SwapInterval() const
+{
+    return this->swapInterval;
+}
+
+void FramePacer::Wait()
+{
+    Clock::time_point now = Clock::now();
+    if (!this->started)
+    {
+        this->started = true;
+        this->deadline = now;
+        this->lastFrame = now;
+    }
+    if (this->period.count() > 0)
+    {
+        // deadlines advance by whole periods so small errors don't accumulate;
+        // after falling behind by more than a frame start over instead of rushing to catch up
+        this->deadline += this->period;
+        if (now - this->deadline > this->period)
+            this->deadline = now;
+        // sleep for the bulk of the remaining time, then spin to hit the deadline precisely
+        if (this->deadline - now > PACING_SPIN_MARGIN)
+            std::this_thread::sleep_for(this->deadline - now - PACING_SPIN_MARGIN);
+        while (Clock::now() < this->deadline)
+            std::this_thread::yield();
+        now = Clock::now();
+    }
+    // record the achieved interval
+    const double interval = std::chrono::duration<double, std::milli>(now - this->lastFrame).count();
+    this->lastFrame = now;
+    if (interval <= 0.0)
+        return;
+    this->minimum = this->frames == 0 ? interval : std::min(this->minimum, interval);
+    this->maximum = std::max(this->maximum, interval);
+    this->sum += interval;
+    this->sumSquares += interval * interval;
+    this->frames++;
+}
+
+void FramePacer::PrintStats() const
+{
+    if (this->frames == 0)
+        return;
+    const double mean = this->sum / this->frames;
+    const double jitter = std::sqrt(std::max(0.0, this->sumSquares / this->frames - mean * mean));
+    std::cout << "FRAMEPACER: " << ModeName(this->Mode) << ": " << this->frames << " frames, mean " << mean
+        << " ms, jitter (std dev) " << jitter << " ms, min " << this->minimum << " ms, max " << this->maximum << " ms" << std::endl;
+}
+
+const char *FramePacer::ModeName(PacingMode mode)
+{
+    static const char *names[PACING_MODES] = { "vsync", "uncapped", "capped", "adaptive" };
+    return names[mode];
+}
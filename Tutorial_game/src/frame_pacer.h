@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+
+
+// How the main loop is paced
+enum PacingMode {
+    PACING_VSYNC,    // swap waits for the vertical blank
+    PACING_UNCAPPED, // no waiting at all
+    PACING_CAPPED,   // waits for the target frame rate (sleep, then spin the last bit)
+    PACING_ADAPTIVE  // vsync that tears instead of waiting when a frame is late;
+                     // capped to the display refresh rate where the driver can't do that
+};
+constexpr unsigned int PACING_MODES = 4;
+
+// Time before a deadline that is spun instead of slept, to absorb the
+// scheduler's wake-up latency
+constexpr std::chrono::microseconds PACING_SPIN_MARGIN(1500);
+
+
+// FramePacer ends every iteration of the main loop at the right time
+// for the selected PacingMode and keeps statistics of the achieved
+// frame intervals, so their jitter can be reported.
+class FramePacer
+{
+public:
+    // settings
+    PacingMode Mode;
+    // constructor
+    FramePacer(PacingMode mode, unsigned int targetFps);
+    // decides the swap interval and frame period; call once with a current GL context
+    void Configure();
+    // swap interval to set (glfwSwapInterval) on the thread owning the GL context
+    int SwapInterval() const;
+    // blocks until the next frame should start and records the achieved frame interval
+    void Wait();
+    // prints the mean frame interval and its jitter
+    void PrintStats() const;
+    // name of a pacing mode as used on the command line
+    static const char *ModeName(PacingMode mode);
+private:
+    using Clock = std::chrono::steady_clock;
+    std::chrono::nanoseconds period;   // 0 if Wait() shouldn't wait
+    int                      swapInterval;
+    Clock::time_point        deadline, lastFrame;
+    bool                     started;
+    // frame interval statistics (milliseconds)
+    unsigned long long frames;
+    double             sum, sumSquares, minimum, maximum;
+};
+
+#endif
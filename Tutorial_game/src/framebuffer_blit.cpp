@@ -0,0 +1,55 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "framebuffer_blit.h"
+#include "software_renderer.h"
+#include "gl_state.h"
+
+#include <iostream>
+
+
+FramebufferBlit::FramebufferBlit(unsigned int width, unsigned int height)
+    : Output(0), Texture()
+{
+    // the image is copied 1:1, there is nothing to filter
+    this->Texture.Internal_Format = GL_RGBA;
+    this->Texture.Image_Format = GL_RGBA;
+    this->Texture.Filter_Min = GL_NEAREST;
+    this->Texture.Filter_Max = GL_NEAREST;
+    this->Texture.Generate(width, height, NULL);
+    glGenFramebuffers(1, &this->FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture.ID, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFERBLIT: Failed to initialize FBO" << std::endl;
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+FramebufferBlit::~FramebufferBlit()
+{
+    GLState::DeleteFramebuffer(this->FBO);
+    GLState::DeleteTexture(this->Texture.ID);
+}
+
+void FramebufferBlit::Present(const SoftwareImage &image)
+{
+    if (image.Width != this->Texture.Width || image.Height != this->Texture.Height)
+    {
+        std::cout << "ERROR::FRAMEBUFFERBLIT: Image of " << image.Width << "x" << image.Height << " doesn't fit the "
+            << this->Texture.Width << "x" << this->Texture.Height << " texture" << std::endl;
+        return;
+    }
+    this->Texture.Bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.Width, image.Height, GL_RGBA, GL_UNSIGNED_BYTE, image.Pixels.data());
+    // GL's rows go bottom up, the image's top down: flip while copying
+    GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, this->FBO);
+    GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, this->Output);
+    glBlitFramebuffer(0, 0, image.Width, image.Height, 0, image.Height, image.Width, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->Output);
+}
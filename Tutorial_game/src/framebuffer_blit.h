@@ -0,0 +1,36 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAMEBUFFER_BLIT_H
+#define FRAMEBUFFER_BLIT_H
+
+#include "texture.h"
+
+struct SoftwareImage;
+
+
+// FramebufferBlit shows images rendered in main memory (see
+// SoftwareRenderer): every image is uploaded into a texture which is
+// then blitted onto the output framebuffer, flipped so the image's top
+// row ends up on top. No shader or geometry is involved.
+class FramebufferBlit
+{
+public:
+    // framebuffer the images are blitted to (0: the backbuffer)
+    unsigned int Output;
+    // constructor/destructor (images have to be of the given size)
+    FramebufferBlit(unsigned int width, unsigned int height);
+    ~FramebufferBlit();
+    // uploads the image and copies it onto the output
+    void Present(const SoftwareImage &image);
+private:
+    Texture2D    Texture;
+    unsigned int FBO;
+};
+
+#endif
@@ -9,80 +9,79 @@
 #include <glm/glm.hpp>
 
 #include "game.h"
-#include "resource_manager.h"
-#include "sprite_renderer.h"
+#include "sprite.h"
+#include "render_queue.h"
 #include "ball_object.h"
-#include "particle_generator.h"
-#include "post_processor.h"
-#include "audio_manager.h"
+#include "particle_system.h"
+#include "swept_collision.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
 
-SpriteRenderer    *Renderer;
-GameObject        *Player;
-BallObject        *Ball;
-ParticleGenerator *Particles;
-PostProcessor     *Effects;
+// A hit of a ball on a brick or the paddle, found while the balls move and applied once all of them moved
+struct BallHit {
+    float        Time;  // fraction of the tick the ball had travelled
+    unsigned int Ball;
+    unsigned int Brick; // PADDLE_HIT for the paddle
+};
+constexpr unsigned int PADDLE_HIT = ~0u;
+
 
+RenderSnapshot    *Frame; // used when recording and drawing on the same thread
+GameObject        *Player;
+ParticleSystem    *Particles;
+// The balls in play, back to back; a life starts with the first one
+std::vector<BallObject> Balls;
+// Most balls in play at once (raised by the stress mode)
+unsigned int BallLimit = MAX_BALLS;
+
+// Post-processing effects enabled by power-ups and collisions (EffectBits)
+unsigned int Effects = 0;
 // Used to time shaking the screen
 float ShakeTime = 0.0f;
-
-Collision CheckCollision(BallObject &one, GameObject &two);
-Direction VectorDirection(glm::vec2 target);
+// Bricks near a ball's path, reused every tick (by every thread moving balls)
+thread_local std::vector<unsigned int> BrickCandidates;
+// Hits of every ball during the current tick, and all of them in the order they happened
+std::vector<std::vector<BallHit>> BallHits;
+std::vector<BallHit> TickHits;
+
+void SweepBall(BallObject &ball, unsigned int index, const GameLevel &level, const GameObject &paddle, float width, float dt, std::vector<BallHit> &hits);
+bool SweepWalls(glm::vec2 center, float radius, glm::vec2 motion, float width, SweptContact &contact);
 bool ShouldSpawn(unsigned int chance);
 bool CheckCollision(GameObject &one, GameObject &two);
 void ActivatePowerUp(PowerUp &powerUp);
+void SplitBalls();
+glm::vec2 Rotate(glm::vec2 vector, float degrees);
 bool isOtherPowerUpActive(std::vector<PowerUp> &powerUps, std::string type);
 
 Game::Game(unsigned int width, unsigned int height) 
-    : State(GAME_ACTIVE), Keys(), Width(width), Height(height)
+    : State(GAME_ACTIVE), Keys(), KeysProcessed(), ParticleMode(PARTICLES_CPU), AAMode(AA_MSAA4), StressBalls(0), Threads(0), Width(width), Height(height), RenderScale(1.0f), Time(0.0f), Audio(nullptr), Renderer(nullptr)
 { 
 
 }
 
 Game::~Game()
 {
-    delete Renderer;
+    delete Frame;
     delete Player;
-    delete Ball;
     delete Particles;
-    delete Effects;
 }
 
-void Game::Init(AudioManager* audio)
+void Game::Init(AudioBackend* audio, GameRenderer* renderer)
 {
-   // load shaders
-    ResourceManager::LoadShader("assets/shaders/sprite.vert", "assets/shaders/sprite.frag", nullptr, "sprite");
-    ResourceManager::LoadShader("assets/shaders/particle.vert", "assets/shaders/particle.frag", nullptr, "particle");
-    ResourceManager::LoadShader("assets/shaders/effects.vert", "assets/shaders/effects.frag", nullptr, "effects");
-    // configure shaders
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width), 
-        static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
-    ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-    ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
-
-    ResourceManager::GetShader("particle").Use().SetMatrix4("projection", projection);
-    ResourceManager::GetShader("particle").SetInteger("sprite", 0);
-
-    // set render-specific controls
-    Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
-
-    // load textures
-    ResourceManager::LoadTexture("assets/textures/background.jpg", false, "background");
-    ResourceManager::LoadTexture("assets/textures/awesomeface.png", true, "face");
-    ResourceManager::LoadTexture("assets/textures/block.png", false, "block");
-    ResourceManager::LoadTexture("assets/textures/block_solid.png", false, "block_solid");
-    ResourceManager::LoadTexture("assets/textures/paddle.png", true, "paddle");
-    ResourceManager::LoadTexture("assets/textures/particle.png", true, "particle");
-
-    ResourceManager::LoadTexture("assets/textures/powerup_chaos.png", true, "chaos");
-    ResourceManager::LoadTexture("assets/textures/powerup_confuse.png", true, "confuse");
-    ResourceManager::LoadTexture("assets/textures/powerup_increase.png", true, "increase");
-    ResourceManager::LoadTexture("assets/textures/powerup_passthrough.png", true, "passthrough");
-    ResourceManager::LoadTexture("assets/textures/powerup_speed.png", true, "speed");
-    ResourceManager::LoadTexture("assets/textures/powerup_sticky.png", true, "sticky");
+    // every ball can leave a trail; the stress mode moves its balls on all threads
+    BallLimit = std::max(MAX_BALLS, this->StressBalls);
+    if (BallLimit >= PARALLEL_BALLS)
+        this->Workers.Start(this->Threads);
+
+    // the renderer loads its resources first, so the sprite regions are known when building the level
+    this->Renderer = renderer;
+    this->Renderer->Init(this->Width, this->Height, this->AAMode, this->ParticleMode, BALL_TRAIL_PARTICLES * BallLimit);
+    Frame = new RenderSnapshot(static_cast<float>(this->Width), static_cast<float>(this->Height));
 
     // load sounds
     this->Audio = audio;
@@ -95,9 +94,6 @@ void Game::Init(AudioManager* audio)
     this->Audio->loadSound("assets/audio/powerup.wav", "pickup_powerup");
     this->Audio->loadSound("assets/audio/bleep.wav", "hit_paddle");
 
-    // Load post-processing resources
-    Effects = new PostProcessor(ResourceManager::GetShader("effects"), this->Width, this->Height);
-
     // load levels
     GameLevel one; one.Load("assets/levels/one.lvl", this->Width, this->Height / 2);
     GameLevel two; two.Load("assets/levels/two.lvl", this->Width, this->Height / 2);
@@ -110,44 +106,78 @@ void Game::Init(AudioManager* audio)
     this->Levels.push_back(four);
     this->Levels.push_back(five);
     this->Level = 0;
+    this->StaticDirty = true;
 
     // configure player
     const glm::vec2 playerPos = glm::vec2(
         this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, 
         this->Height - PLAYER_SIZE.y
     );
-    Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::GetTexture("paddle"));
+    Player = new GameObject(playerPos, PLAYER_SIZE, SpriteRegistry::Get("paddle"));
 
-    // configure ball
+    // configure ball(s)
     const glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, 
                                               -BALL_RADIUS * 2.0f);
 
-    Ball = new BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY,
-        ResourceManager::GetTexture("face"));
+    Balls.assign(1, BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY,
+        SpriteRegistry::Get("face")));
+    this->ResetBalls();
 
     // configure particles
-    Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), 
-        ResourceManager::GetTexture("particle"), 500);
+    Particles = new ParticleSystem(SpriteRegistry::Get("particle"), BALL_TRAIL_PARTICLES * BallLimit, this->ParticleMode);
 
     // play music
     this->Audio->play("gamemusic");
 }
 
+void Game::Tick(float dt)
+{
+    // remember where everything was, so frames in between ticks can interpolate
+    Player->PreviousPosition = Player->Position;
+    for (BallObject &ball : Balls)
+        ball.PreviousPosition = ball.Position;
+    for (PowerUp &powerUp : this->PowerUps)
+        powerUp.PreviousPosition = powerUp.Position;
+
+    this->ProcessInput(dt);
+    this->Update(dt);
+    this->Time += dt;
+}
+
+void Game::AutoPlay()
+{
+    // keep the center of the paddle under the center of the lowest ball coming down (or the first one)
+    const BallObject *ball = &Balls.front();
+    for (const BallObject &other : Balls)
+        if (!other.Stuck && other.Velocity.y > 0.0f && (ball->Velocity.y <= 0.0f || other.Position.y > ball->Position.y))
+            ball = &other;
+    const float target = ball->Position.x + ball->Radius - Player->Size.x / 2.0f;
+    this->Keys[KEY_A] = target < Player->Position.x - 1.0f;
+    this->Keys[KEY_D] = target > Player->Position.x + 1.0f;
+    this->Keys[KEY_SPACE] = true;
+}
+
 void Game::Update(float dt)
 {
-    // update objects
-    Ball->Move(dt, this->Width);
-    // check for collisions
+    // move the balls, bouncing off bricks, paddle and walls
+    this->MoveBalls(dt);
+    // check for collisions of the power-ups
     this->DoCollisions();
 
-    if (Ball->Position.y > this->Height) // did ball reach bottom edge?
+    // balls past the bottom edge are lost; losing the last one resets the level
+    const auto lost = [this](const BallObject &ball) { return ball.Position.y > this->Height; };
+    if (std::all_of(Balls.begin(), Balls.end(), lost))
     {
         this->ResetLevel();
         this->ResetPlayer();
     }
+    else
+        Balls.erase(std::remove_if(Balls.begin(), Balls.end(), lost), Balls.end());
 
-    // update particles
-    Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2.0f));
+    // update particles: every ball leaves a trail
+    for (BallObject &ball : Balls)
+        Particles->Spawn(ball, 2, glm::vec2(ball.Radius / 2.0f));
+    Particles->Update(dt);
 
     // update PowerUps
     this->UpdatePowerUps(dt);
@@ -157,7 +187,7 @@ void Game::Update(float dt)
     {
         ShakeTime -= dt;
         if (ShakeTime <= 0.0f)
-            Effects->Shake = false;
+            Effects &= ~EFFECT_SHAKE;
     }
 }
 
@@ -169,134 +199,164 @@ void Game::ProcessInput(float dt)
         const float first_pos = Player->Position.x;
         
         // move playerboard
-        if (this->Keys[GLFW_KEY_A])
+        if (this->Keys[KEY_A])
         {
             Player->Position.x -= velocity;
         }
-        if (this->Keys[GLFW_KEY_D])
+        if (this->Keys[KEY_D])
         {
             Player->Position.x += velocity;
         }
         // Prevent moving off-screen
         Player->Position.x = std::clamp(Player->Position.x, 0.0f, this->Width - Player->Size.x);
 
-        // Move ball
+        // Move the balls stuck to the paddle along
         const float moved_dist = Player->Position.x - first_pos;
-        if (Ball->Stuck)
-            Ball->Position.x += moved_dist;
+        for (BallObject &ball : Balls)
+        {
+            if (ball.Stuck)
+                ball.Position.x += moved_dist;
 
-        if (this->Keys[GLFW_KEY_SPACE])
-            Ball->Stuck = false;
+            if (this->Keys[KEY_SPACE])
+                ball.Stuck = false;
+        }
+    }
+    // cycle through the anti-aliasing modes
+    if (this->Keys[KEY_M] && !this->KeysProcessed[KEY_M])
+    {
+        // applied when the next frame is drawn
+        this->AAMode = static_cast<AntiAliasing>((this->AAMode + 1) % AA_MODES);
+        std::cout << "Anti-aliasing: " << AntiAliasingName(this->AAMode) << std::endl;
+        this->KeysProcessed[KEY_M] = true;
     }
 }
 
-void Game::Render()
+void Game::Render(float alpha)
 {
-    if (this->State == GAME_ACTIVE)
-    {
-        Effects->BeginRender();
+    this->Record(*Frame, alpha);
+    this->Render(*Frame);
+}
 
-        // draw background
-        Renderer->DrawSprite(ResourceManager::GetTexture("background"), 
-            glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f
-        );
-        // draw level
-        this->Levels[this->Level].Draw(*Renderer);
+void Game::Record(RenderSnapshot &frame, float alpha)
+{
+    frame.Queue.Clear();
+    frame.Active = this->State == GAME_ACTIVE;
+    frame.Effects = Effects;
+    frame.AA = this->AAMode;
+    frame.RenderScale = this->RenderScale;
+    frame.Time = this->Time;
+    if (frame.Active)
+    {
+        RenderQueue &queue = frame.Queue;
+        // the layers keep the draw order
+        // draw background and solid bricks, re-baking them only when the level changed
+        if (this->StaticDirty)
+        {
+            const TextureRegion background = SpriteRegistry::Get("background");
+            std::vector<StaticSprite> sprites;
+            sprites.push_back({ background.ID, SpriteInstance::Make(background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height)) });
+            this->Levels[this->Level].DrawStatic(sprites);
+            queue.PushLayerBake(std::move(sprites));
+            this->StaticDirty = false;
+        }
+        queue.PushStaticLayer(LAYER_BACKGROUND);
+        // draw the destructible bricks of the level
+        this->Levels[this->Level].Draw(queue);
 
         // draw powerups
         for (PowerUp &powerUp : this->PowerUps)
             if (!powerUp.Destroyed)
-                powerUp.Draw(*Renderer);
+                powerUp.Draw(queue, LAYER_POWERUPS, alpha);
 
         // draw player
-        Player->Draw(*Renderer);
-
-        // draw particles
-        if (!Ball->Stuck)
-            Particles->Draw();
+        Player->Draw(queue, LAYER_PLAYER, alpha);
 
-        // draw ball
-        Ball->Draw(*Renderer);
+        // draw particles (unless all balls wait on the paddle; they are recorded anyway, so the
+        // GPU backend's spawns and time don't pile up meanwhile)
+        Particles->Record(frame.Particles);
+        frame.Particles.Visible = std::any_of(Balls.begin(), Balls.end(), [](const BallObject &ball) { return !ball.Stuck; });
+        queue.PushParticles(LAYER_PARTICLES, Particles->TextureID(), frame.Particles);
 
-        Effects->EndRender();
-        Effects->Render(glfwGetTime());
+        // draw balls
+        for (BallObject &ball : Balls)
+            ball.Draw(queue, LAYER_BALL, alpha);
     }
 }
 
-void Game::DoCollisions()
+void Game::Render(RenderSnapshot &frame)
 {
-    for (GameObject &box : this->Levels[this->Level].Bricks)
-    {
-        if (!box.Destroyed)
-        {
-            const Collision collision = CheckCollision(*Ball, box);
-            if (std::get<0>(collision)) // if collision is true
-            {
-                // destroy block if not solid
-                if (!box.IsSolid)
-                {
-                    box.Destroyed = true;
-                    this->SpawnPowerUps(box);
+    this->Renderer->Draw(frame);
+}
 
-                    this->Audio->play("hit_nonsolid");
-                }
-                else
-                {   // if block is solid, enable shake effect
-                    ShakeTime = 0.05f;
-                    Effects->Shake = true;
+void Game::PrintStats()
+{
+    this->Renderer->PrintStats();
+}
 
-                    this->Audio->play("hit_solid");
-                }
-                // collision resolution
-                if (!box.IsSolid && Ball->PassThrough) continue;
-                
-                const Direction dir = std::get<1>(collision);
-                const glm::vec2 diff_vector = std::get<2>(collision);
-                if (dir == LEFT || dir == RIGHT) // horizontal collision
-                {
-                    Ball->Velocity.x = -Ball->Velocity.x; // reverse horizontal velocity
-                    // relocate
-                    const float penetration = Ball->Radius - std::abs(diff_vector.x);
-                    if (dir == LEFT)
-                        Ball->Position.x += penetration; // move ball to right
-                    else
-                        Ball->Position.x -= penetration; // move ball to left;
-                }
-                else // vertical collision
-                {
-                    Ball->Velocity.y = -Ball->Velocity.y; // reverse vertical velocity
-                    // relocate
-                    const float penetration = Ball->Radius - std::abs(diff_vector.y);
-                    if (dir == UP)
-                        Ball->Position.y -= penetration; // move ball back up
-                    else
-                        Ball->Position.y += penetration; // move ball back down
-                }
-            }
-        }
-    }
+void Game::SetRenderScale(float scale)
+{
+    this->RenderScale = scale; // applied when the next frame is drawn
+}
+
+float Game::GpuFrameTime() const
+{
+    return this->Renderer->GpuFrameTime();
+}
 
-    const Collision result = CheckCollision(*Ball, *Player);
-    if (!Ball->Stuck && std::get<0>(result))
+void Game::MoveBalls(float dt)
+{
+    GameLevel &level = this->Levels[this->Level];
+    // every ball moves on its own against the bricks as they were when the tick began, so
+    // (with enough of them to be worth it) they move in parallel
+    BallHits.resize(Balls.size());
+    const auto move = [this, &level, dt](unsigned int i)
     {
-        // check where it hit the board, and change velocity based on where it hit the board
-        float centerBoard = Player->Position.x + Player->Size.x / 2.0f;
-        float distance = (Ball->Position.x + Ball->Radius) - centerBoard;
-        float percentage = distance / (Player->Size.x / 2.0f);
-        // then move accordingly
-        float strength = 2.0f;
-        glm::vec2 oldVelocity = Ball->Velocity;
-        Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength; 
-        Ball->Velocity.y = -Ball->Velocity.y;
-        Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
-        
-        Ball->Velocity.y = -1.0f * abs(Ball->Velocity.y);
+        BallHits[i].clear();
+        SweepBall(Balls[i], i, level, *Player, static_cast<float>(this->Width), dt, BallHits[i]);
+    };
+    if (Balls.size() >= PARALLEL_BALLS)
+        this->Workers.ParallelFor(static_cast<unsigned int>(Balls.size()), move);
+    else
+        for (unsigned int i = 0; i < Balls.size(); ++i)
+            move(i);
+
+    // then the hits take effect in the order they happened (ties: the lower ball first), which
+    // doesn't depend on the threads: a brick several balls hit in the same tick is destroyed (and
+    // spawns power-ups) once, by the first hit; the other balls still bounced off it, as it stood
+    // when their tick began
+    TickHits.clear();
+    for (unsigned int i = 0; i < Balls.size(); ++i)
+        TickHits.insert(TickHits.end(), BallHits[i].begin(), BallHits[i].end());
+    std::stable_sort(TickHits.begin(), TickHits.end(), [](const BallHit &a, const BallHit &b) { return a.Time < b.Time; });
+    for (const BallHit &hit : TickHits)
+    {
+        if (hit.Brick == PADDLE_HIT)
+        {
+            this->Audio->play("hit_paddle");
+            continue;
+        }
+        // destroy block if not solid
+        if (!level.IsSolid(hit.Brick))
+        {
+            if (level.IsDestroyed(hit.Brick)) // by an earlier hit of this tick
+                continue;
+            level.DestroyBrick(hit.Brick);
+            this->SpawnPowerUps(level.BrickPosition(hit.Brick));
 
-        Ball->Stuck = Ball->Sticky;
+            this->Audio->play("hit_nonsolid");
+        }
+        else
+        {   // if block is solid, enable shake effect
+            ShakeTime = 0.05f;
+            Effects |= EFFECT_SHAKE;
 
-        this->Audio->play("hit_paddle");
+            this->Audio->play("hit_solid");
+        }
     }
+}
 
+void Game::DoCollisions()
+{
     for (PowerUp &powerUp : this->PowerUps)
     {
         if (!powerUp.Destroyed)
@@ -325,6 +385,7 @@ void Game::ResetLevel()
         this->Levels[2].Load("assets/levels/three.lvl", this->Width, this->Height / 2);
     else if (this->Level == 3)
         this->Levels[3].Load("assets/levels/four.lvl", this->Width, this->Height / 2);
+    this->StaticDirty = true;
 }
 
 void Game::ResetPlayer()
@@ -332,41 +393,62 @@ void Game::ResetPlayer()
     // reset player/ball stats
     Player->Size = PLAYER_SIZE;
     Player->Position = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
-    Ball->Reset(Player->Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -(BALL_RADIUS * 2.0f)), INITIAL_BALL_VELOCITY);
+    Player->PreviousPosition = Player->Position;
+    this->ResetBalls();
+}
+
+void Game::ResetBalls()
+{
+    // the first ball keeps its power-ups; the stress mode's copies of it are fanned out evenly
+    const unsigned int count = std::max(1u, this->StressBalls);
+    const glm::vec2 position = Player->Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -(BALL_RADIUS * 2.0f));
+    Balls.resize(1);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (i > 0)
+            Balls.push_back(Balls.front());
+        const float angle = count > 1 ? STRESS_FAN_ANGLE * (static_cast<float>(i) / (count - 1) - 0.5f) : 0.0f;
+        Balls[i].Reset(position, Rotate(INITIAL_BALL_VELOCITY, angle));
+    }
 }
 
-void Game::SpawnPowerUps(GameObject &block)
+void Game::SpawnPowerUps(glm::vec2 position)
 {
-    const Texture2D tex_speed = ResourceManager::GetTexture("speed");
-    const Texture2D tex_sticky = ResourceManager::GetTexture("sticky");
-    const Texture2D tex_pass = ResourceManager::GetTexture("passthrough");
-    const Texture2D tex_size = ResourceManager::GetTexture("increase");
-    const Texture2D tex_confuse = ResourceManager::GetTexture("confuse");
-    const Texture2D tex_chaos = ResourceManager::GetTexture("chaos");
+    const TextureRegion tex_speed = SpriteRegistry::Get("speed");
+    const TextureRegion tex_sticky = SpriteRegistry::Get("sticky");
+    const TextureRegion tex_pass = SpriteRegistry::Get("passthrough");
+    const TextureRegion tex_size = SpriteRegistry::Get("increase");
+    const TextureRegion tex_confuse = SpriteRegistry::Get("confuse");
+    const TextureRegion tex_chaos = SpriteRegistry::Get("chaos");
+    const TextureRegion tex_multi = SpriteRegistry::Get("multiball");
 
     if (ShouldSpawn(75)) // 1 in 75 chance
         this->PowerUps.push_back(
-             PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, block.Position, tex_speed
+             PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, position, tex_speed
          ));
     if (ShouldSpawn(75))
         this->PowerUps.push_back(
-            PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, block.Position, tex_sticky 
+            PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, position, tex_sticky 
+        ));
+    if (ShouldSpawn(75))
+        this->PowerUps.push_back(
+            PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, position, tex_pass
         ));
     if (ShouldSpawn(75))
         this->PowerUps.push_back(
-            PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, block.Position, tex_pass
+            PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, position, tex_size    
         ));
     if (ShouldSpawn(75))
         this->PowerUps.push_back(
-            PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, block.Position, tex_size    
+            PowerUp("multi-ball", glm::vec3(1.0f, 1.0f, 0.5f), 0.0f, position, tex_multi
         ));
     if (ShouldSpawn(15)) // negative powerups should spawn more often
         this->PowerUps.push_back(
-            PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, block.Position, tex_confuse
+            PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, position, tex_confuse
         ));
     if (ShouldSpawn(15))
         this->PowerUps.push_back(
-            PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, block.Position, tex_chaos
+            PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, position, tex_chaos
         ));
 }
 
@@ -388,7 +470,8 @@ void Game::UpdatePowerUps(float dt)
                 {
                     if (!isOtherPowerUpActive(this->PowerUps, "sticky"))
                     {	// only reset if no other PowerUp of type sticky is active
-                        Ball->Sticky = false;
+                        for (BallObject &ball : Balls)
+                            ball.Sticky = false;
                         Player->Color = glm::vec3(1.0f);
                     }
                 }
@@ -396,22 +479,25 @@ void Game::UpdatePowerUps(float dt)
                 {
                     if (!isOtherPowerUpActive(this->PowerUps, "pass-through"))
                     {	// only reset if no other PowerUp of type pass-through is active
-                        Ball->PassThrough = false;
-                        Ball->Color = glm::vec3(1.0f);
+                        for (BallObject &ball : Balls)
+                        {
+                            ball.PassThrough = false;
+                            ball.Color = glm::vec3(1.0f);
+                        }
                     }
                 }
                 else if (powerUp.Type == "confuse")
                 {
                     if (!isOtherPowerUpActive(this->PowerUps, "confuse"))
                     {	// only reset if no other PowerUp of type confuse is active
-                        Effects->Confuse = false;
+                        Effects &= ~EFFECT_CONFUSE;
                     }
                 }
                 else if (powerUp.Type == "chaos")
                 {
                     if (!isOtherPowerUpActive(this->PowerUps, "chaos"))
                     {	// only reset if no other PowerUp of type chaos is active
-                        Effects->Chaos = false;
+                        Effects &= ~EFFECT_CHAOS;
                     }
                 }                
             }
@@ -459,6 +545,114 @@ bool CheckCollision(GameObject &one, GameObject &two) // AABB - AABB collision
     return collisionX && collisionY;
 }
 
+// moves a ball by one tick from contact to contact, bouncing off whatever it touches first, until
+// the motion of the tick is used up (nothing is ever pushed out after the fact). It only reads the
+// level and the paddle, so balls can move in parallel; their brick and paddle hits are recorded.
+void SweepBall(BallObject &ball, unsigned int index, const GameLevel &level, const GameObject &paddle, float width, float dt, std::vector<BallHit> &hits)
+{
+    if (ball.Stuck)
+        return;
+    // the non-solid bricks this ball hit are gone for it, even if the hit takes effect later
+    const auto hitBefore = [&hits](unsigned int brick)
+    {
+        return std::any_of(hits.begin(), hits.end(), [brick](const BallHit &hit) { return hit.Brick == brick; });
+    };
+    float remaining = 1.0f;
+    for (unsigned int bounce = 0; bounce < MAX_BALL_BOUNCES && remaining > 0.0f; ++bounce)
+    {
+        const glm::vec2 center = ball.Position + ball.Radius;
+        const glm::vec2 motion = ball.Velocity * dt * remaining;
+        enum { HIT_NONE, HIT_BRICK, HIT_PADDLE, HIT_WALL } hit = HIT_NONE;
+        SweptContact first = { 1.0f, glm::vec2(0.0f) }, contact;
+        unsigned int brick = 0;
+        // only the bricks near the path can be hit; ties go to the lowest index
+        const glm::vec2 pathMin = glm::min(center, center + motion) - ball.Radius;
+        const glm::vec2 pathMax = glm::max(center, center + motion) + ball.Radius;
+        level.BricksInArea(pathMin, pathMax, BrickCandidates);
+        for (unsigned int i : BrickCandidates)
+        {
+            const glm::vec2 boxMin = level.BrickPosition(i);
+            if (SweepCircleBox(center, ball.Radius, motion, boxMin, boxMin + level.BrickSize(i), contact) && contact.Time < first.Time
+                && (level.IsSolid(i) || !hitBefore(i)))
+            {
+                first = contact;
+                hit = HIT_BRICK;
+                brick = i;
+            }
+        }
+        if (SweepCircleBox(center, ball.Radius, motion, paddle.Position, paddle.Position + paddle.Size, contact) && contact.Time < first.Time)
+        {
+            first = contact;
+            hit = HIT_PADDLE;
+        }
+        if (SweepWalls(center, ball.Radius, motion, width, contact) && contact.Time < first.Time)
+        {
+            first = contact;
+            hit = HIT_WALL;
+        }
+
+        // move up to the contact, then respond to it
+        ball.Position += motion * first.Time;
+        const float time = 1.0f - remaining * (1.0f - first.Time);
+        remaining *= 1.0f - first.Time;
+        if (hit == HIT_NONE)
+            break;
+        if (hit == HIT_BRICK)
+        {
+            hits.push_back({ time, index, brick });
+            // a pass-through ball keeps going through the (soon destroyed) brick
+            if (level.IsSolid(brick) || !ball.PassThrough)
+                ball.Velocity = Reflect(ball.Velocity, first.Normal);
+        }
+        else if (hit == HIT_PADDLE)
+        {
+            // check where it hit the board, and change velocity based on where it hit the board
+            float centerBoard = paddle.Position.x + paddle.Size.x / 2.0f;
+            float distance = (ball.Position.x + ball.Radius) - centerBoard;
+            float percentage = distance / (paddle.Size.x / 2.0f);
+            // then move accordingly
+            float strength = 2.0f;
+            glm::vec2 oldVelocity = ball.Velocity;
+            ball.Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength; 
+            ball.Velocity.y = -ball.Velocity.y;
+            ball.Velocity = glm::normalize(ball.Velocity) * glm::length(oldVelocity);
+            
+            ball.Velocity.y = -1.0f * abs(ball.Velocity.y);
+
+            ball.Stuck = ball.Sticky;
+
+            hits.push_back({ time, index, PADDLE_HIT });
+            if (ball.Stuck)
+                break;
+        }
+        else
+            ball.Velocity = Reflect(ball.Velocity, first.Normal);
+    }
+}
+
+// earliest contact of a moving circle with the left, right and top wall (the bottom is open)
+bool SweepWalls(glm::vec2 center, float radius, glm::vec2 motion, float width, SweptContact &contact)
+{
+    bool hit = false;
+    contact.Time = 1.0f;
+    // distance of the center to a wall's plane (moved inwards by the radius) and the speed towards it
+    auto sweep = [&](float distance, float speed, glm::vec2 normal)
+    {
+        if (speed <= 0.0f)
+            return;
+        const float time = std::max(distance / speed, 0.0f);
+        if (time < contact.Time)
+        {
+            contact = { time, normal };
+            hit = true;
+        }
+    };
+    sweep(center.x - radius, -motion.x, glm::vec2(1.0f, 0.0f));
+    sweep(width - radius - center.x, motion.x, glm::vec2(-1.0f, 0.0f));
+    sweep(center.y - radius, -motion.y, glm::vec2(0.0f, 1.0f));
+    return hit;
+}
+
 Direction VectorDirection(glm::vec2 target)
 {
     constexpr glm::vec2 compass[] = {
@@ -485,34 +679,66 @@ void ActivatePowerUp(PowerUp &powerUp)
 {
     if (powerUp.Type == "speed")
     {
-        Ball->Velocity *= 1.2;
+        for (BallObject &ball : Balls)
+            ball.Velocity *= 1.2;
     }
     else if (powerUp.Type == "sticky")
     {
-        Ball->Sticky = true;
+        for (BallObject &ball : Balls)
+            ball.Sticky = true;
         Player->Color = glm::vec3(1.0f, 0.5f, 1.0f);
     }
     else if (powerUp.Type == "pass-through")
     {
-        Ball->PassThrough = true;
-        Ball->Color = glm::vec3(1.0f, 0.5f, 0.5f);
+        for (BallObject &ball : Balls)
+        {
+            ball.PassThrough = true;
+            ball.Color = glm::vec3(1.0f, 0.5f, 0.5f);
+        }
     }
     else if (powerUp.Type == "pad-size-increase")
     {
         Player->Size.x += 50;
     }
+    else if (powerUp.Type == "multi-ball")
+    {
+        SplitBalls();
+    }
     else if (powerUp.Type == "confuse")
     {
-        if (!Effects->Chaos)
-            Effects->Confuse = true; // only activate if chaos wasn't already active
+        if (!(Effects & EFFECT_CHAOS))
+            Effects |= EFFECT_CONFUSE; // only activate if chaos wasn't already active
     }
     else if (powerUp.Type == "chaos")
     {
-        if (!Effects->Confuse)
-            Effects->Chaos = true;
+        if (!(Effects & EFFECT_CONFUSE))
+            Effects |= EFFECT_CHAOS;
     }
 }
 
+void SplitBalls()
+{
+    // every ball in play gets two copies turned away from it to either side (as long as there is room)
+    const unsigned int count = static_cast<unsigned int>(Balls.size());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        for (float angle : { MULTIBALL_ANGLE, -MULTIBALL_ANGLE })
+        {
+            if (Balls.size() >= BallLimit)
+                return;
+            Balls.push_back(Balls[i]);
+            Balls.back().Velocity = Rotate(Balls[i].Velocity, angle);
+        }
+    }
+}
+
+glm::vec2 Rotate(glm::vec2 vector, float degrees)
+{
+    const float radians = glm::radians(degrees);
+    const float c = std::cos(radians), s = std::sin(radians);
+    return glm::vec2(c * vector.x - s * vector.y, s * vector.x + c * vector.y);
+}
+
 bool ShouldSpawn(unsigned int chance)
 {
     unsigned int random = rand() % chance;
@@ -12,12 +12,14 @@
 #include <vector>
 #include <tuple>
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-
 #include "game_level.h"
 #include "power_up.h"
-#include "audio_manager.h"
+#include "particle_system.h"
+#include "render_queue.h"
+#include "render_settings.h"
+#include "audio_backend.h"
+#include "game_renderer.h"
+#include "worker_pool.h"
 
 // Represents the current state of the game
 enum GameState {
@@ -34,9 +36,23 @@ enum Direction {
 	LEFT
 };
 
+// Keys the game reacts to (the codes match GLFW's, which are ASCII for printable keys)
+enum GameKey {
+    KEY_SPACE = 32,
+    KEY_A     = 65,
+    KEY_D     = 68,
+    KEY_M     = 77
+};
+
 // Defines a Collision tuple that represents collision data
 using Collision = std::tuple<bool, Direction, glm::vec2>;
 
+class BallObject;
+// Circle - AABB test of the ball against one object, one at a time (CollideCircleBoxes tests many at once)
+Collision CheckCollision(BallObject &one, GameObject &two);
+// Which of the four directions a vector points closest to
+Direction VectorDirection(glm::vec2 target);
+
 // Initial size of the player paddle
 constexpr glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
 // Initial velocity of the player paddle
@@ -44,45 +60,114 @@ constexpr float PLAYER_VELOCITY = 500.0f;
 
 constexpr float BALL_RADIUS = 12.5f;
 constexpr glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
+// Most contacts the ball resolves within one tick; motion left after that is dropped
+constexpr unsigned int MAX_BALL_BOUNCES = 8;
+// Number of particles in the trail of each ball
+constexpr unsigned int BALL_TRAIL_PARTICLES = 500;
+// Most balls in play at once outside the stress mode (the multi-ball power-up stops adding balls there)
+constexpr unsigned int MAX_BALLS = 16;
+// Angle in degrees the two balls the multi-ball power-up adds for every ball are turned away from it
+constexpr float MULTIBALL_ANGLE = 20.0f;
+// Angle in degrees the balls of the stress mode are fanned out over when launched
+constexpr float STRESS_FAN_ANGLE = 120.0f;
+// Fewest balls whose movement is worth spreading over the worker threads
+constexpr unsigned int PARALLEL_BALLS = 32;
+
+// Everything needed to draw one frame. It is filled by Game::Record
+// without touching GL and consumed by Game::Render, possibly on
+// another thread.
+struct RenderSnapshot {
+    bool          Active;      // whether there is a scene to draw
+    RenderQueue   Queue;
+    ParticleFrame Particles;
+    unsigned int  Effects;     // EffectBits
+    AntiAliasing  AA;
+    float         RenderScale;
+    float         Time;
+
+    RenderSnapshot(float width, float height)
+        : Active(false), Queue(width, height), Particles(), Effects(0), AA(AA_MSAA4), RenderScale(1.0f), Time(0.0f) { }
+};
 
 // Game holds all game-related state and functionality.
 // Combines all game-related data into a single class for
 // easy access to each of the components and manageability.
+// The simulation never touches GL or the sound device itself: frames
+// are drawn by a GameRenderer and sounds played through an
+// AudioBackend, so the game also runs headless (see NullRenderer
+// and NullAudio).
 class Game
 {
 public:
     // game state
     bool                    Keys[1024];
+    bool                    KeysProcessed[1024];
+    // settings (take effect in Init)
+    ParticleBackend         ParticleMode;
+    AntiAliasing            AAMode;
+    // balls every life starts with, fanned out (0 or 1: normal play; more: stress mode)
+    unsigned int            StressBalls;
+    // threads the balls move on in the stress mode (0: one per hardware thread)
+    unsigned int            Threads;
     // constructor/destructor
     Game(unsigned int width, unsigned int height);
     ~Game();
-    // initialize game state (load all shaders/textures/levels)
-    void Init(AudioManager* audio);
+    // initialize game state (initializes the renderer, then loads all levels and sounds)
+    void Init(AudioBackend* audio, GameRenderer* renderer);
     // game loop
     void ProcessInput(float dt);
     void Update(float dt);
-    void Render();
+    // advances the simulation by one fixed step (input and update)
+    void Tick(float dt);
+    // steers the paddle towards the ball and launches it (drives headless runs instead of a player)
+    void AutoPlay();
+    // alpha interpolates moving objects between the last two ticks (0 = previous, 1 = current)
+    void Render(float alpha = 1.0f);
+    // records the current frame into a snapshot (no GL calls)
+    void Record(RenderSnapshot &frame, float alpha = 1.0f);
+    // draws a recorded frame (on the thread owning the renderer's context)
+    void Render(RenderSnapshot &frame);
+    // prints the performance statistics gathered so far (on the thread owning the renderer's context)
+    void PrintStats();
+    // renders the scene at a fraction of the window resolution
+    void SetRenderScale(float scale);
+    // GPU time of the most recently measured frame in seconds (a few frames old)
+    float GpuFrameTime() const;
 
 private:
     // game state
     GameState               State;
     unsigned int            Width, Height;
+    float                   RenderScale;
+    // simulated time in seconds
+    float                   Time;
 
     std::vector<PowerUp>  PowerUps;
 
     // level tracking
     std::vector<GameLevel> Levels;
     unsigned int           Level;
-
-    // audio
-    AudioManager* Audio;
+    // set whenever the current level is (re)loaded or switched, so the static layer is re-baked
+    bool                   StaticDirty;
+
+    // audio and rendering backends
+    AudioBackend* Audio;
+    GameRenderer* Renderer;
+    // threads the balls move on
+    WorkerPool    Workers;
     
+    // moves the balls by one tick (each resolving its contacts with bricks, paddle and walls on
+    // the way), then applies their brick and paddle hits in the order they happened
+    void MoveBalls(float dt);
+    // picks up the power-ups the paddle touches
     void DoCollisions();
 
     void ResetLevel();
     void ResetPlayer();
+    // puts the first ball (and in the stress mode, copies of it) back onto the paddle
+    void ResetBalls();
 
-    void SpawnPowerUps(GameObject &block);
+    void SpawnPowerUps(glm::vec2 position);
     void UpdatePowerUps(float dt);
 };
 
@@ -10,12 +10,21 @@
 
 #include <fstream>
 #include <sstream>
+#include <utility>
 
 
 void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
 {
     // clear old data
-    this->Bricks.clear();
+    this->positions.clear();
+    this->sizes.clear();
+    this->colors.clear();
+    this->types.clear();
+    this->destroyed.clear();
+    this->remaining = 0;
+    this->dirtyBricks.clear();
+    this->uploaded = false;
+    this->grid = BrickGrid();
     // load from file
     unsigned int tileCode;
     std::string line;
@@ -36,19 +45,73 @@ void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int lev
     }
 }
 
-void GameLevel::Draw(SpriteRenderer &renderer)
+void GameLevel::Draw(RenderQueue &queue)
 {
-    for (GameObject &tile : this->Bricks)
-        if (!tile.Destroyed)
-            tile.Draw(renderer);
+    if (this->positions.empty())
+        return;
+    if (!this->uploaded)
+    {   // first draw after (re)loading: upload all destructible bricks at once (solid ones live in the static layer)
+        std::vector<SpriteInstance> instances;
+        this->bufferIndex.assign(this->BrickCount(), 0);
+        for (unsigned int i = 0; i < this->BrickCount(); ++i)
+        {
+            if (this->IsSolid(i))
+                continue;
+            this->bufferIndex[i] = instances.size();
+            instances.push_back(this->brickInstance(i));
+        }
+        this->bufferTexture = this->sprites[BRICK_DESTRUCTIBLE].ID;
+        queue.PushBufferUpload(this->buffer, std::move(instances));
+        this->uploaded = true;
+        this->dirtyBricks.clear();
+    }
+    // patch only the bricks destroyed since the last frame
+    for (unsigned int index : this->dirtyBricks)
+        queue.PushBufferPatch(this->buffer, this->bufferIndex[index], this->brickInstance(index));
+    this->dirtyBricks.clear();
+    // all bricks share the atlas page of the block textures, so the whole level is a single draw call
+    queue.PushSpriteBuffer(LAYER_LEVEL, this->buffer, this->bufferTexture);
 }
 
-bool GameLevel::IsCompleted()
+void GameLevel::DrawStatic(std::vector<StaticSprite> &sprites) const
 {
-    for (GameObject &tile : this->Bricks)
-        if (!tile.IsSolid && !tile.Destroyed)
-            return false;
-    return true;
+    for (unsigned int i = 0; i < this->BrickCount(); ++i)
+        if (this->IsSolid(i))
+            sprites.push_back({ this->sprites[BRICK_SOLID].ID, this->brickInstance(i) });
+}
+
+void GameLevel::DestroyBrick(unsigned int index)
+{
+    // solid bricks are baked into the static layer and can't be destroyed (nor can bricks be twice)
+    if (this->IsSolid(index) || this->IsDestroyed(index))
+        return;
+    this->destroyed[index / 64] |= std::uint64_t(1) << (index % 64);
+    this->remaining--;
+    this->dirtyBricks.push_back(index);
+    this->grid.Remove(index, this->positions[index], this->sizes[index]);
+}
+
+void GameLevel::BricksInArea(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const
+{
+    this->grid.Query(min, max, bricks);
+}
+
+SpriteInstance GameLevel::brickInstance(unsigned int brick) const
+{
+    const glm::vec2 size = this->IsDestroyed(brick) ? glm::vec2(0.0f) : this->sizes[brick];
+    return SpriteInstance::Make(this->sprites[this->types[brick]], this->positions[brick], size, 0.0f, BRICK_COLORS[this->colors[brick]]);
+}
+
+void GameLevel::addBrick(glm::vec2 position, glm::vec2 size, unsigned char color, BrickType type)
+{
+    if (this->positions.size() % 64 == 0)
+        this->destroyed.push_back(0);
+    this->positions.push_back(position);
+    this->sizes.push_back(size);
+    this->colors.push_back(color);
+    this->types.push_back(type);
+    if (type != BRICK_SOLID)
+        this->remaining++;
 }
 
 void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight)
@@ -57,6 +120,8 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
     unsigned int height = tileData.size();
     unsigned int width = tileData[0].size(); // note we can index vector at [0] since this function is only called if height > 0
     float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height; 
+    this->sprites[BRICK_SOLID] = SpriteRegistry::Get("block_solid");
+    this->sprites[BRICK_DESTRUCTIBLE] = SpriteRegistry::Get("block");
     // initialize level tiles based on tileData		
     for (unsigned int y = 0; y < height; ++y)
     {
@@ -73,25 +138,11 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
 
             // check block type from level data (2D level array)
             if (tile == 1) // solid
-            {
-                GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-                obj.IsSolid = true;
-                this->Bricks.push_back(obj);
-            }
-            else if (tile > 1)	// non-solid; now determine its color based on level data
-            {
-                glm::vec3 color = glm::vec3(1.0f); // original: white
-                switch (tile)
-                {
-                    case 2: color = glm::vec3(0.2f, 0.6f, 1.0f); break; // blue
-                    case 3: color = glm::vec3(0.0f, 0.7f, 0.0f); break; // green
-                    case 4: color = glm::vec3(0.8f, 0.8f, 0.4f); break; // yellow
-                    case 5: color = glm::vec3(1.0f, 0.5f, 0.0f); break; // orange
-                    default: break;
-                }
-
-                this->Bricks.push_back(GameObject(pos, size, ResourceManager::GetTexture("block"), color));
-            }
+                this->addBrick(pos, size, 1, BRICK_SOLID);
+            else	// non-solid; its color is based on level data (original: white)
+                this->addBrick(pos, size, tile <= 5 ? tile : 0, BRICK_DESTRUCTIBLE);
         }
     }
+    // the tiles are the grid's cells
+    this->grid.Build(glm::vec2(unit_width, unit_height), width, height, this->positions, this->sizes);
 }
@@ -9,34 +9,91 @@
 #ifndef GAMELEVEL_H
 #define GAMELEVEL_H
 
+#include <cstdint>
 #include <vector>
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "game_object.h"
-#include "sprite_renderer.h"
-#include "resource_manager.h"
+#include "sprite.h"
+#include "render_queue.h"
+#include "brick_grid.h"
+
+
+// Kinds of bricks
+enum BrickType : unsigned char {
+    BRICK_SOLID,       // can't be destroyed
+    BRICK_DESTRUCTIBLE
+};
+
+// Colors of the bricks by index: the tile code of the level file for
+// destructible bricks up to 5 (0: any other code), 1 for solid bricks
+constexpr glm::vec3 BRICK_COLORS[] = {
+    glm::vec3(1.0f),              // white
+    glm::vec3(0.8f, 0.8f, 0.7f),  // solid
+    glm::vec3(0.2f, 0.6f, 1.0f),  // blue
+    glm::vec3(0.0f, 0.7f, 0.0f),  // green
+    glm::vec3(0.8f, 0.8f, 0.4f),  // yellow
+    glm::vec3(1.0f, 0.5f, 0.0f)   // orange
+};
 
 
 /// GameLevel holds all Tiles as part of a Breakout level and 
 /// hosts functionality to Load/render levels from the harddisk.
+/// The bricks are stored as structure of arrays (position, size,
+/// color index and type; brick i is index i of each) with a bitset of
+/// the destroyed ones and a count of the destructible bricks still
+/// standing, so checking for completion doesn't scan the level.
+/// The bricks are uploaded to the GPU once after loading; destroying
+/// a brick only patches its own instance. The buffer itself is only
+/// touched when the render queue is submitted. Solid bricks are not
+/// part of it; they are drawn through the game's static layer.
+/// For collisions the bricks still standing are indexed in a uniform
+/// grid matching the level's layout (see BrickGrid).
 class GameLevel
 {
 public:
-    // level state
-    std::vector<GameObject> Bricks;
     // constructor
-    GameLevel() { }
+    GameLevel() : remaining(0), uploaded(false), bufferTexture(0) { }
     // loads level from file
     void Load(const char *file, unsigned int levelWidth, unsigned int levelHeight);
-    // render level
-    void Draw(SpriteRenderer &renderer);
+    // records the changes to the level's GPU buffer and its draw in the render queue (solid bricks excluded)
+    void Draw(RenderQueue &queue);
+    // appends the solid bricks, which never change, for baking into a static layer
+    void DrawStatic(std::vector<StaticSprite> &sprites) const;
+    // destroys the brick at the given index (solid bricks can't be)
+    void DestroyBrick(unsigned int index);
+    // replaces the contents of bricks with the indices of the standing bricks near the area, in ascending order
+    void BricksInArea(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const;
     // check if the level is completed (all non-solid tiles are destroyed)
-    bool IsCompleted();
+    bool IsCompleted() const { return this->remaining == 0; }
+    // the bricks by index (destroyed ones included)
+    unsigned int BrickCount() const { return static_cast<unsigned int>(this->positions.size()); }
+    glm::vec2    BrickPosition(unsigned int brick) const { return this->positions[brick]; }
+    glm::vec2    BrickSize(unsigned int brick) const { return this->sizes[brick]; }
+    bool         IsSolid(unsigned int brick) const { return this->types[brick] == BRICK_SOLID; }
+    bool         IsDestroyed(unsigned int brick) const { return (this->destroyed[brick / 64] >> (brick % 64)) & 1u; }
 private:
+    // level state
+    std::vector<glm::vec2>          positions, sizes;
+    std::vector<unsigned char>      colors;    // index into BRICK_COLORS
+    std::vector<BrickType>          types;
+    std::vector<std::uint64_t>      destroyed; // bit (i % 64) of word (i / 64) is set once brick i is destroyed
+    unsigned int                    remaining; // destructible bricks still standing
+    TextureRegion                   sprites[2]; // by BrickType
+    // render state
+    SpriteBuffer              buffer;
+    bool                      uploaded;
+    std::vector<unsigned int> dirtyBricks;
+    std::vector<unsigned int> bufferIndex; // brick index -> instance in buffer
+    unsigned int              bufferTexture;
+    // collision broadphase
+    BrickGrid                 grid;
     // initialize level from tile data
     void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
+    // appends a brick
+    void addBrick(glm::vec2 position, glm::vec2 size, unsigned char color, BrickType type);
+    // instance data of a brick; destroyed bricks collapse to an empty quad
+    SpriteInstance brickInstance(unsigned int brick) const;
 };
 
 #endif
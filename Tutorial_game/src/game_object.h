@@ -9,11 +9,10 @@
 #ifndef GAMEOBJECT_H
 #define GAMEOBJECT_H
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "texture.h"
-#include "sprite_renderer.h"
+#include "sprite.h"
+#include "render_queue.h"
 
 
 // Container object for holding all state relevant for a single
@@ -24,17 +23,19 @@ class GameObject
 public:
     // object state
     glm::vec2   Position, Size, Velocity;
+    glm::vec2   PreviousPosition; // Position at the start of the current simulation tick
     glm::vec3   Color;
     float       Rotation;
     bool        IsSolid;
     bool        Destroyed;
     // render state
-    Texture2D   Sprite;	
+    TextureRegion Sprite;
     // constructor(s)
     GameObject();
-    GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
-    // draw sprite
-    virtual void Draw(SpriteRenderer &renderer);
+    GameObject(glm::vec2 pos, glm::vec2 size, TextureRegion sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
+    // record the sprite in the given layer of the render queue, interpolated between
+    // the previous and current tick by alpha
+    virtual void Draw(RenderQueue &queue, RenderLayer layer, float alpha = 1.0f);
 };
 
 #endif
@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GAME_RENDERER_H
+#define GAME_RENDERER_H
+
+#include "render_settings.h"
+#include "particle_system.h"
+
+struct RenderSnapshot;
+
+// An image the game draws with and the name of its sprite region
+struct SpriteAsset {
+    const char *File;
+    bool        Alpha; // whether the image's alpha channel is used (otherwise it is opaque)
+    const char *Name;
+};
+
+// The full screen background
+constexpr SpriteAsset BACKGROUND_ASSET = { "assets/textures/background.jpg", false, "background" };
+// Every other sprite image; renderers load these in Init
+constexpr SpriteAsset SPRITE_ASSETS[] = {
+    { "assets/textures/awesomeface.png",         true,  "face" },
+    { "assets/textures/block.png",               false, "block" },
+    { "assets/textures/block_solid.png",         false, "block_solid" },
+    { "assets/textures/paddle.png",              true,  "paddle" },
+    { "assets/textures/particle.png",            true,  "particle" },
+    { "assets/textures/powerup_chaos.png",       true,  "chaos" },
+    { "assets/textures/powerup_confuse.png",     true,  "confuse" },
+    { "assets/textures/powerup_increase.png",    true,  "increase" },
+    { "assets/textures/powerup_multiball.png",   true,  "multiball" },
+    { "assets/textures/powerup_passthrough.png", true,  "passthrough" },
+    { "assets/textures/powerup_speed.png",       true,  "speed" },
+    { "assets/textures/powerup_sticky.png",      true,  "sticky" }
+};
+
+
+// GameRenderer draws the frames the Game records. The simulation only
+// talks to this interface and never to GL itself, so it runs the same
+// with the OpenGL renderer (GLRenderer), on the CPU (SoftwareRenderer)
+// or without any (NullRenderer).
+class GameRenderer
+{
+public:
+    virtual ~GameRenderer() { }
+    // loads all render resources and registers the sprite regions the game draws with (see SpriteRegistry)
+    virtual void Init(unsigned int width, unsigned int height, AntiAliasing aa, ParticleBackend particles, unsigned int particleCount) = 0;
+    // draws a recorded frame (on the thread owning the renderer's context, if any)
+    virtual void Draw(RenderSnapshot &frame) = 0;
+    // prints the performance statistics gathered so far
+    virtual void PrintStats() = 0;
+    // GPU time of the most recently measured frame in seconds (a few frames old); 0 if not measured
+    virtual float GpuFrameTime() const = 0;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "gl_renderer.h"
+#include "game.h"
+#include "resource_manager.h"
+#include "gl_state.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+
+
+GLRenderer::GLRenderer()
+    : sprites(nullptr), background(nullptr), particles(nullptr), effects(nullptr), queueStats(), lastGpuTime(0.0f)
+{
+
+}
+
+GLRenderer::~GLRenderer()
+{
+    delete this->sprites;
+    delete this->background;
+    delete this->particles;
+    delete this->effects;
+}
+
+void GLRenderer::Init(unsigned int width, unsigned int height, AntiAliasing aa, ParticleBackend particles, unsigned int particleCount)
+{
+    // load shaders
+    ResourceManager::LoadShader("assets/shaders/sprite.vert", "assets/shaders/sprite.frag", nullptr, "sprite");
+    ResourceManager::LoadShader("assets/shaders/particle.vert", "assets/shaders/particle.frag", nullptr, "particle");
+    // configure shaders
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width), 
+        static_cast<float>(height), 0.0f, -1.0f, 1.0f);
+    ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
+    ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
+
+    ResourceManager::GetShader("particle").Use().SetMatrix4("projection", projection);
+    ResourceManager::GetShader("particle").SetInteger("sprite", 0);
+
+    // set render-specific controls
+    this->sprites = new SpriteRenderer(ResourceManager::GetShader("sprite"));
+    this->background = new StaticLayer(width, height);
+
+    // load textures
+    ResourceManager::LoadTexture(BACKGROUND_ASSET.File, BACKGROUND_ASSET.Alpha, BACKGROUND_ASSET.Name);
+    SpriteRegistry::Regions[BACKGROUND_ASSET.Name] = ResourceManager::GetTexture(BACKGROUND_ASSET.Name);
+    // small sprites share a single atlas so a whole frame needs (almost) no texture rebinds
+    for (const SpriteAsset &asset : SPRITE_ASSETS)
+        ResourceManager::AddToAtlas(asset.File, asset.Alpha, asset.Name);
+    ResourceManager::BuildAtlas("sprites");
+
+    // the GPU side of the ball trail
+    this->particles = new ParticleGenerator(ResourceManager::GetShader("particle"), 
+        ResourceManager::GetRegion("particle"), particleCount, particles);
+
+    // Load post-processing resources
+    this->effects = new PostProcessor(width, height, aa);
+}
+
+void GLRenderer::Draw(RenderSnapshot &frame)
+{
+    // settings changed by the game side take effect here, where the GL context lives
+    if (frame.AA != this->effects->AA)
+        this->effects->SetAntiAliasing(frame.AA);
+    if (frame.RenderScale != this->effects->RenderScale)
+        this->effects->SetRenderScale(frame.RenderScale);
+    if (frame.Active)
+    {
+        this->effects->BeginRender(frame.Effects);
+        // sort by state and draw everything
+        this->submit(frame.Queue);
+        this->effects->EndRender();
+        this->effects->Render(frame.Time);
+    }
+    this->lastGpuTime = this->effects->LastFrameTime / 1000.0f;
+}
+
+void GLRenderer::PrintStats()
+{
+    this->effects->PrintTimings();
+    const RenderQueueStats &stats = this->queueStats;
+    std::cout << "RENDERQUEUE: last frame: " << stats.Commands << " commands, " << stats.Culled << " culled, "
+        << stats.DrawCalls << " draw calls, " << stats.PipelineChanges << " shader / " << stats.TextureChanges
+        << " texture / " << stats.BlendChanges << " blend changes" << std::endl;
+    std::cout << "STATICLAYER: baked " << this->background->Bakes << " times" << std::endl;
+    std::cout << "GLSTATE: last frame: issued=" << GLState::LastFrameIssued << " skipped=" << GLState::LastFrameSkipped
+        << " (redundant state calls filtered out)" << std::endl;
+    std::cout << "SHADER: last frame: " << Shader::LastFrameLookups << " uniform lookups by name, "
+        << Shader::LastFrameDriverLookups << " glGetUniformLocation calls" << std::endl;
+}
+
+float GLRenderer::GpuFrameTime() const
+{
+    return this->lastGpuTime;
+}
+
+void GLRenderer::SetOutput(unsigned int framebuffer)
+{
+    this->effects->Output = framebuffer;
+}
+
+void GLRenderer::submit(RenderQueue &queue)
+{
+    SpriteRenderer &renderer = *this->sprites;
+    const unsigned int drawCalls = renderer.DrawCalls;
+    // bring the static layer and resident buffers up to date first, in recording order
+    for (const LayerBake &bake : queue.Bakes())
+        this->background->Bake(renderer, bake.Sprites);
+    for (const BufferUpdate &update : queue.Updates())
+    {
+        if (update.Index < 0)
+            renderer.UploadBuffer(*update.Buffer, update.Instances);
+        else
+            renderer.UpdateBuffer(*update.Buffer, update.Index, update.Instances[0]);
+    }
+    queue.Sort();
+    unsigned int particleDraws = 0;
+    renderer.Begin();
+    for (unsigned int i = 0; i < queue.Size(); ++i)
+    {
+        const RenderCommand &command = queue.Command(i);
+        switch (command.Type)
+        {
+        case COMMAND_SPRITE:
+            renderer.SubmitInstance(command.Texture, command.Instance);
+            break;
+        case COMMAND_SPRITE_BUFFER:
+            renderer.DrawBuffer(*command.Buffer, command.Texture);
+            break;
+        case COMMAND_STATIC_LAYER:
+        {
+            SpriteInstance instance = command.Instance;
+            instance.TexRect = this->background->Region().UV;
+            renderer.SubmitInstance(this->background->Texture.ID, instance);
+            break;
+        }
+        case COMMAND_PARTICLES:
+            // particles bypass the sprite batch, so everything queued before has to be drawn first
+            renderer.Flush();
+            this->particles->Draw(*command.ParticleData);
+            particleDraws += command.ParticleData->Visible ? 1 : 0;
+            renderer.Begin();
+            break;
+        }
+    }
+    renderer.Flush();
+    queue.Stats.DrawCalls = renderer.DrawCalls - drawCalls + particleDraws;
+    this->queueStats = queue.Stats;
+    queue.Clear();
+}
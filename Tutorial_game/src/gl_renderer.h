@@ -0,0 +1,54 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GL_RENDERER_H
+#define GL_RENDERER_H
+
+#include <atomic>
+
+#include "game_renderer.h"
+#include "sprite_renderer.h"
+#include "static_layer.h"
+#include "particle_generator.h"
+#include "post_processor.h"
+#include "render_queue.h"
+
+
+// GLRenderer draws the game with OpenGL: it owns every GL resource
+// (shaders, textures, the sprite batcher, the static layer, the GPU
+// side of the particles and the post-processing targets) and submits
+// the recorded render queues. All its functions have to be called on
+// the thread owning the GL context.
+class GLRenderer : public GameRenderer
+{
+public:
+    // constructor/destructor
+    GLRenderer();
+    ~GLRenderer();
+    // loads all shaders and textures and allocates the render targets
+    void Init(unsigned int width, unsigned int height, AntiAliasing aa, ParticleBackend particles, unsigned int particleCount) override;
+    void Draw(RenderSnapshot &frame) override;
+    void PrintStats() override;
+    float GpuFrameTime() const override;
+    // sends the final image to the given framebuffer instead of the backbuffer (after Init)
+    void SetOutput(unsigned int framebuffer);
+private:
+    // render state
+    SpriteRenderer    *sprites;
+    StaticLayer       *background; // background and solid bricks of the current level
+    ParticleGenerator *particles;
+    PostProcessor     *effects;
+    // render queue statistics of the last drawn frame
+    RenderQueueStats   queueStats;
+    // written by the render thread, read by the game thread
+    std::atomic<float> lastGpuTime;
+    // applies the recorded bakes and buffer changes, then draws the queue's commands in sorted order
+    void submit(RenderQueue &queue);
+};
+
+#endif
@@ -0,0 +1,150 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "gl_state.h"
+
+// Marks shadowed state as unknown so the next call is always issued
+constexpr unsigned int UNKNOWN = ~0u;
+
+// Instantiate static variables
+unsigned int GLState::IssuedCalls = 0;
+unsigned int GLState::SkippedCalls = 0;
+unsigned int GLState::LastFrameIssued = 0;
+unsigned int GLState::LastFrameSkipped = 0;
+unsigned int GLState::program = UNKNOWN;
+unsigned int GLState::activeUnit = UNKNOWN;
+unsigned int GLState::textures[MAX_TRACKED_TEXTURE_UNITS] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+unsigned int GLState::vao = UNKNOWN;
+GLenum       GLState::blendSrc = UNKNOWN;
+GLenum       GLState::blendDst = UNKNOWN;
+unsigned int GLState::readFramebuffer = UNKNOWN;
+unsigned int GLState::drawFramebuffer = UNKNOWN;
+
+
+void GLState::UseProgram(unsigned int program)
+{
+    if (changed(GLState::program, program))
+        glUseProgram(program);
+}
+
+void GLState::BindTexture(unsigned int texture, unsigned int unit)
+{
+    if (unit >= MAX_TRACKED_TEXTURE_UNITS)
+    {   // untracked unit: always bind
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        activeUnit = unit;
+        IssuedCalls += 2;
+        return;
+    }
+    if (textures[unit] == texture)
+    {
+        SkippedCalls++;
+        return;
+    }
+    if (changed(activeUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    textures[unit] = texture;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    IssuedCalls++;
+}
+
+void GLState::BindVertexArray(unsigned int vao)
+{
+    if (changed(GLState::vao, vao))
+        glBindVertexArray(vao);
+}
+
+void GLState::BlendFunc(GLenum src, GLenum dst)
+{
+    if (blendSrc == src && blendDst == dst)
+    {
+        SkippedCalls++;
+        return;
+    }
+    blendSrc = src;
+    blendDst = dst;
+    glBlendFunc(src, dst);
+    IssuedCalls++;
+}
+
+void GLState::BindFramebuffer(GLenum target, unsigned int framebuffer)
+{
+    if (target == GL_FRAMEBUFFER)
+    {
+        if (readFramebuffer == framebuffer && drawFramebuffer == framebuffer)
+        {
+            SkippedCalls++;
+            return;
+        }
+        readFramebuffer = drawFramebuffer = framebuffer;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        IssuedCalls++;
+    }
+    else if (changed(target == GL_READ_FRAMEBUFFER ? readFramebuffer : drawFramebuffer, framebuffer))
+        glBindFramebuffer(target, framebuffer);
+}
+
+void GLState::DeleteProgram(unsigned int program)
+{
+    if (GLState::program == program)
+        GLState::program = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void GLState::DeleteTexture(unsigned int texture)
+{
+    for (unsigned int &bound : textures)
+        if (bound == texture)
+            bound = UNKNOWN;
+    glDeleteTextures(1, &texture);
+}
+
+void GLState::DeleteVertexArray(unsigned int vao)
+{
+    if (GLState::vao == vao)
+        GLState::vao = UNKNOWN;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLState::DeleteFramebuffer(unsigned int framebuffer)
+{
+    if (readFramebuffer == framebuffer)
+        readFramebuffer = UNKNOWN;
+    if (drawFramebuffer == framebuffer)
+        drawFramebuffer = UNKNOWN;
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLState::Reset()
+{
+    program = activeUnit = vao = UNKNOWN;
+    for (unsigned int &bound : textures)
+        bound = UNKNOWN;
+    blendSrc = blendDst = UNKNOWN;
+    readFramebuffer = drawFramebuffer = UNKNOWN;
+}
+
+void GLState::NewFrame()
+{
+    LastFrameIssued = IssuedCalls;
+    LastFrameSkipped = SkippedCalls;
+    IssuedCalls = SkippedCalls = 0;
+}
+
+bool GLState::changed(unsigned int &current, unsigned int value)
+{
+    if (current == value)
+    {
+        SkippedCalls++;
+        return false;
+    }
+    current = value;
+    IssuedCalls++;
+    return true;
+}
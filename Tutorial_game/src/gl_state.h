@@ -0,0 +1,59 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Number of texture units whose bindings are tracked
+constexpr unsigned int MAX_TRACKED_TEXTURE_UNITS = 8;
+
+
+// A static singleton GLState class that shadows the OpenGL state the
+// renderers touch (program, texture per unit, vertex array, blend
+// function and framebuffers) and skips calls that would not change
+// anything. All binds in the game should route through it, otherwise
+// the shadow copy goes stale; call Reset() after foreign GL code.
+class GLState
+{
+public:
+    // state changes
+    static void UseProgram(unsigned int program);
+    static void BindTexture(unsigned int texture, unsigned int unit = 0);
+    static void BindVertexArray(unsigned int vao);
+    static void BlendFunc(GLenum src, GLenum dst);
+    static void BindFramebuffer(GLenum target, unsigned int framebuffer);
+    // deletes GL objects and forgets their bindings so a recycled name is bound again
+    static void DeleteProgram(unsigned int program);
+    static void DeleteTexture(unsigned int texture);
+    static void DeleteVertexArray(unsigned int vao);
+    static void DeleteFramebuffer(unsigned int framebuffer);
+    // forgets all shadowed state; the next call of every kind reaches the driver
+    static void Reset();
+    // closes the statistics of the current frame
+    static void NewFrame();
+    // calls forwarded to / skipped before the driver during the current frame
+    static unsigned int IssuedCalls, SkippedCalls;
+    // the same numbers for the last completed frame
+    static unsigned int LastFrameIssued, LastFrameSkipped;
+private:
+    // private constructor, that is we do not want any actual GLState objects
+    GLState() { }
+    // shadowed state
+    static unsigned int program;
+    static unsigned int activeUnit;
+    static unsigned int textures[MAX_TRACKED_TEXTURE_UNITS];
+    static unsigned int vao;
+    static GLenum       blendSrc, blendDst;
+    static unsigned int readFramebuffer, drawFramebuffer;
+    // counts a call and returns whether it has to be issued
+    static bool changed(unsigned int &current, unsigned int value);
+};
+
+#endif
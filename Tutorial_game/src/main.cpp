@@ -12,14 +12,46 @@
 #include "game.h"
 #include "resource_manager.h"
 #include "audio_manager.h"
+#include "gl_renderer.h"
+#include "null_renderer.h"
+#include "software_renderer.h"
+#include "framebuffer_blit.h"
+#include "offscreen_target.h"
+#include "gl_state.h"
+#include "dynamic_resolution.h"
+#include "snapshot_buffer.h"
+#include "frame_pacer.h"
+#include "ball_object.h"
+#include "collision_kernel.h"
 
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <random>
 
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+// Render thread of the threaded mode
+void render_loop(GLFWwindow* window, SnapshotBuffer* snapshots, int swapInterval);
+// Runs the simulation without window, GL context or sound device (drawing
+// on the CPU only with the software renderer)
+int run_headless(unsigned long long ticks, unsigned int tickRate, bool software);
+// Times CheckCollision against the batch kernel (scalar and vectorized) on random
+// boxes and circles, checking that they agree
+int run_collision_benchmark(unsigned int boxes);
+// Initializes GLFW and creates a window with a current GL context; offscreen it
+// uses the null platform (no display) with the given context creation API
+GLFWwindow* create_context(bool offscreen, int contextApi);
+// Renders scripted frames into an offscreen target, saving (and comparing) PNGs
+int run_offscreen(unsigned int frames, const std::string &directory, unsigned int captureEvery, const std::string &goldenDirectory, int contextApi, unsigned int tickRate, bool software);
 
 // The Width of the screen
 constexpr unsigned int SCREEN_WIDTH = 800;
@@ -27,53 +59,185 @@ constexpr unsigned int SCREEN_WIDTH = 800;
 constexpr unsigned int SCREEN_HEIGHT = 600;
 // Framerate
 constexpr unsigned int FPS = 240;
+// Longest frame the simulation catches up on; anything beyond is dropped instead
+// of running a burst of ticks (which would only make the next frame late as well)
+constexpr float MAX_FRAME_DELTA = 0.25f;
+// Largest difference per color channel from a golden image that still counts
+// as equal (rasterizers may round differently)
+constexpr int GOLDEN_TOLERANCE = 2;
 
 Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
+GLRenderer Renderer;
+SoftwareRenderer Software;
 
 int main(int argc, char *argv[])
 {
+    // command line options
+    bool dynamicResolution = false;
+    bool threaded = false;
+    bool software = false;
+    PacingMode pacing = PACING_CAPPED;
+    unsigned int tickRate = FPS;
+    unsigned long long headlessTicks = 0;
+    unsigned int benchmarkBoxes = 0;
+    unsigned int offscreenFrames = 0, captureEvery = 0;
+    std::string offscreenDirectory, goldenDirectory;
+    int contextApi = GLFW_EGL_CONTEXT_API;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--gpu-particles") == 0)
+            Breakout.ParticleMode = PARTICLES_GPU; // simulate particles with transform feedback
+        else if (std::strcmp(argv[i], "--dynamic-resolution") == 0)
+            dynamicResolution = true; // scale the scene resolution to stay within the frame budget
+        else if (std::strcmp(argv[i], "--threaded") == 0)
+            threaded = true; // draw on a dedicated render thread while the next frame is simulated
+        else if (std::strcmp(argv[i], "--aa") == 0 && i + 1 < argc)
+        {
+            ++i;
+            unsigned int mode = 0;
+            while (mode < AA_MODES && std::strcmp(argv[i], AntiAliasingName(static_cast<AntiAliasing>(mode))) != 0)
+                ++mode;
+            if (mode < AA_MODES)
+                Breakout.AAMode = static_cast<AntiAliasing>(mode);
+            else
+                std::cout << "Unknown anti-aliasing mode: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+        {
+            const int rate = std::atoi(argv[++i]);
+            if (rate > 0)
+                tickRate = rate; // simulation steps per second
+            else
+                std::cout << "Invalid tick rate: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--balls") == 0 && i + 1 < argc)
+        {
+            const int balls = std::atoi(argv[++i]);
+            if (balls > 0)
+                Breakout.StressBalls = balls; // start every life with this many balls
+            else
+                std::cout << "Invalid ball count: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--sim-threads") == 0 && i + 1 < argc)
+            Breakout.Threads = std::atoi(argv[++i]); // threads the balls move on in the stress mode
+        else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            const long long ticks = std::atoll(argv[++i]);
+            if (ticks > 0)
+                headlessTicks = ticks; // simulate this many ticks as fast as possible, then exit
+            else
+                std::cout << "Invalid tick count: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--bench-collisions") == 0 && i + 1 < argc)
+        {
+            const int boxes = std::atoi(argv[++i]);
+            if (boxes > 0)
+                benchmarkBoxes = boxes; // time the collision tests against this many boxes, then exit
+            else
+                std::cout << "Invalid box count: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--offscreen") == 0 && i + 2 < argc)
+        {
+            const int frames = std::atoi(argv[++i]);
+            offscreenDirectory = argv[++i];
+            if (frames > 0)
+                offscreenFrames = frames; // render this many frames without a window, saving PNGs to the directory
+            else
+                std::cout << "Invalid frame count: " << argv[i - 1] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--offscreen-api") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (std::strcmp(argv[i], "egl") == 0)
+                contextApi = GLFW_EGL_CONTEXT_API;
+            else if (std::strcmp(argv[i], "osmesa") == 0)
+                contextApi = GLFW_OSMESA_CONTEXT_API;
+            else
+                std::cout << "Unknown context API: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--capture-every") == 0 && i + 1 < argc)
+            captureEvery = std::atoi(argv[++i]); // also save every n-th offscreen frame, not only the last one
+        else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+            goldenDirectory = argv[++i]; // compare the saved offscreen frames against the PNGs in this directory
+        else if (std::strcmp(argv[i], "--renderer") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (std::strcmp(argv[i], "gl") == 0)
+                software = false;
+            else if (std::strcmp(argv[i], "software") == 0)
+                software = true; // rasterize on the CPU, GL only shows the result
+            else
+                std::cout << "Unknown renderer: " << argv[i] << std::endl;
+        }
+        else if (std::strcmp(argv[i], "--raster-threads") == 0 && i + 1 < argc)
+            Software.Threads = std::atoi(argv[++i]); // threads of the software renderer (0: all hardware threads)
+        else if (std::strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+        {
+            ++i;
+            unsigned int mode = 0;
+            while (mode < PACING_MODES && std::strcmp(argv[i], FramePacer::ModeName(static_cast<PacingMode>(mode))) != 0)
+                ++mode;
+            if (mode < PACING_MODES)
+                pacing = static_cast<PacingMode>(mode);
+            else
+                std::cout << "Unknown pacing mode: " << argv[i] << std::endl;
+        }
+        else
+            std::cout << "Unknown option: " << argv[i] << std::endl;
+    }
+
+    if (benchmarkBoxes > 0)
+        return run_collision_benchmark(benchmarkBoxes);
+    if (headlessTicks > 0)
+        return run_headless(headlessTicks, tickRate, software);
+    if (offscreenFrames > 0)
+        return run_offscreen(offscreenFrames, offscreenDirectory, captureEvery, goldenDirectory, contextApi, tickRate, software);
+
     AudioManager Audio;
     // Audio.loadSound("assets/audio/breakout.mp3", "breakout");
     // Audio.setLooping("breakout", true);
     // Audio.play("breakout");
 
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
-    glfwWindowHint(GLFW_RESIZABLE, false);
-
-    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Breakout", nullptr, nullptr);
-    glfwMakeContextCurrent(window);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    GLFWwindow* window = create_context(false, 0);
+    if (!window)
         return -1;
-    }
+
+    // frame pacing (the swap interval belongs to the context)
+    FramePacer pacer(pacing, FPS);
+    pacer.Configure();
+    glfwSwapInterval(pacer.SwapInterval());
 
     glfwSetKeyCallback(window, key_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // OpenGL configuration
-    // --------------------
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
     // initialize game
     // ---------------
-    Breakout.Init(&Audio);
+    FramebufferBlit *blit = nullptr;
+    if (software)
+    {   // the software renderer's frames are blitted into the backbuffer
+        blit = new FramebufferBlit(SCREEN_WIDTH, SCREEN_HEIGHT);
+        Software.Presenter = blit;
+    }
+    Breakout.Init(&Audio, software ? static_cast<GameRenderer*>(&Software) : &Renderer);
 
     // deltaTime variables
     // -------------------
     float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+    float lastFrame = glfwGetTime();
+    // the simulation advances in fixed steps; rendering interpolates in between
+    const float tickTime = 1.0f / tickRate;
+    float accumulator = 0.0f;
+    DynamicResolution resolution(1.0f / FPS);
+
+    // in threaded mode the GL context moves over to the render thread
+    // ----------------------------------------------------------------
+    SnapshotBuffer snapshots(SCREEN_WIDTH, SCREEN_HEIGHT);
+    std::thread renderThread;
+    if (threaded)
+    {
+        glfwMakeContextCurrent(nullptr);
+        renderThread = std::thread(render_loop, window, &snapshots, pacer.SwapInterval());
+    }
 
     while (!glfwWindowShouldClose(window))
     {
@@ -85,28 +249,63 @@ int main(int argc, char *argv[])
 
         glfwPollEvents();
 
-        // manage user input
-        // -----------------
-        Breakout.ProcessInput(deltaTime);
-
-        // update game state
-        // -----------------
-        Breakout.Update(deltaTime);
+        // manage user input and update game state in fixed steps
+        // --------------------------------------------------------
+        accumulator += std::min(deltaTime, MAX_FRAME_DELTA);
+        while (accumulator >= tickTime)
+        {
+            Breakout.Tick(tickTime);
+            accumulator -= tickTime;
+        }
+        const float alpha = accumulator / tickTime;
 
         // render
         // ------
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        Breakout.Render();
+        // the CPU time of the frame is taken before handing it over: both the swap and the
+        // publish can block on presentation (vsync), which says nothing about the frame's cost
+        float frameTime;
+        if (threaded)
+        {   // only record the frame; the render thread draws it while we move on
+            Breakout.Record(snapshots.WriteSlot(), alpha);
+            frameTime = glfwGetTime() - currentFrame;
+            snapshots.Publish();
+        }
+        else
+        {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            Breakout.Render(alpha);
+            frameTime = glfwGetTime() - currentFrame;
 
-        glfwSwapBuffers(window);
+            glfwSwapBuffers(window);
+            // close the redundant state call and uniform lookup statistics of this frame
+            GLState::NewFrame();
+            Shader::NewFrame();
+        }
+
+        // the slower of CPU and GPU (see GpuFrameTime) decides whether the frame fit the budget
+        if (dynamicResolution && resolution.AddFrame(std::max(frameTime, Breakout.GpuFrameTime())))
+            Breakout.SetRenderScale(resolution.Scale);
+        pacer.Wait();
+    }
 
-        const float frameTime = glfwGetTime() - currentFrame;
-        std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int>(1e9 * (1.0f / FPS - frameTime)) ));
+    // stop the render thread and take the GL context back
+    // -------------------------------------------------
+    if (threaded)
+    {
+        snapshots.Close();
+        renderThread.join();
+        glfwMakeContextCurrent(window);
     }
 
+    // report the GPU cost of idle vs. post-processed frames
+    // ----------------------------------------------------
+    Breakout.PrintStats();
+    pacer.PrintStats();
+
     // delete all resources as loaded using the resource manager
     // ---------------------------------------------------------
+    delete blit;
     ResourceManager::Clear();
 
     glfwTerminate();
@@ -123,7 +322,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         if (action == GLFW_PRESS)
             Breakout.Keys[key] = true;
         else if (action == GLFW_RELEASE)
+        {
             Breakout.Keys[key] = false;
+            Breakout.KeysProcessed[key] = false;
+        }
     }
 }
 
@@ -133,3 +335,246 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
 }
+
+void render_loop(GLFWwindow* window, SnapshotBuffer* snapshots, int swapInterval)
+{
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(swapInterval);
+    while (RenderSnapshot *frame = snapshots->Acquire())
+    {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        Breakout.Render(*frame);
+
+        glfwSwapBuffers(window);
+        GLState::NewFrame();
+        Shader::NewFrame();
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+int run_headless(unsigned long long ticks, unsigned int tickRate, bool software)
+{
+    NullAudio audio;
+    NullRenderer renderer;
+    Breakout.Init(&audio, software ? static_cast<GameRenderer*>(&Software) : &renderer);
+
+    // record (and discard) frames at the usual frame rate of simulated time
+    const float tickTime = 1.0f / tickRate;
+    const unsigned int ticksPerFrame = std::max(1u, tickRate / FPS);
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned long long tick = 0; tick < ticks; ++tick)
+    {
+        Breakout.AutoPlay();
+        Breakout.Tick(tickTime);
+        if (tick % ticksPerFrame == 0)
+            Breakout.Render();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "HEADLESS: " << ticks << " ticks (" << ticks * tickTime << " s simulated) in " << seconds << " s, "
+        << ticks / seconds << " ticks per second; " << audio.Played << " sounds" << std::endl;
+    Breakout.PrintStats();
+    return 0;
+}
+
+int run_collision_benchmark(unsigned int boxes)
+{
+    // brick sized boxes and ball sized circles scattered over the screen (the same ones every run)
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> x(0.0f, SCREEN_WIDTH), y(0.0f, SCREEN_HEIGHT);
+    std::vector<GameObject> objects;
+    BoxBatch batch;
+    const glm::vec2 brickSize(SCREEN_WIDTH / 15.0f, SCREEN_HEIGHT / 16.0f);
+    for (unsigned int i = 0; i < boxes; ++i)
+    {
+        objects.emplace_back(glm::vec2(x(random), y(random)), brickSize, TextureRegion());
+        batch.Add(objects.back().Position, objects.back().Size);
+    }
+    // enough circles for about 50 million box tests per run
+    const unsigned int circleCount = std::max(1u, 50000000u / boxes);
+    std::vector<BallObject> circles;
+    for (unsigned int i = 0; i < circleCount; ++i)
+        circles.emplace_back(glm::vec2(x(random), y(random)), BALL_RADIUS, glm::vec2(0.0f), TextureRegion());
+
+    // each variant reports its time per box test in ns and the total number of hits
+    auto time = [&](auto &&test, unsigned long long &hits)
+    {
+        hits = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (BallObject &circle : circles)
+            hits += test(circle);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (static_cast<double>(circleCount) * boxes);
+    };
+    unsigned long long hitsSingle, hitsScalar, hitsKernel;
+    BoxContacts contacts;
+    const double single = time([&](BallObject &circle)
+    {
+        unsigned int hits = 0;
+        for (GameObject &object : objects)
+            hits += std::get<0>(CheckCollision(circle, object));
+        return hits;
+    }, hitsSingle);
+    const double scalar = time([&](BallObject &circle) { return CollideCircleBoxesScalar(circle.Position + circle.Radius, circle.Radius, batch, contacts); }, hitsScalar);
+    const double kernel = time([&](BallObject &circle) { return CollideCircleBoxes(circle.Position + circle.Radius, circle.Radius, batch, contacts); }, hitsKernel);
+
+    // the kernel has to find the same hits and (but for centers inside a box, where CheckCollision has no direction) the same sides
+    unsigned int hitMismatches = 0, directionMismatches = 0;
+    BoxContacts reference;
+    for (unsigned int i = 0; i < std::min(circleCount, 10000u); ++i)
+    {
+        BallObject &circle = circles[i];
+        const glm::vec2 center = circle.Position + circle.Radius;
+        CollideCircleBoxes(center, circle.Radius, batch, contacts);
+        CollideCircleBoxesScalar(center, circle.Radius, batch, reference);
+        for (unsigned int box = 0; box < boxes; ++box)
+        {
+            const Collision collision = CheckCollision(circle, objects[box]);
+            if (std::get<0>(collision) != contacts.Hit(box) || reference.Hit(box) != contacts.Hit(box))
+                hitMismatches++;
+            else if (contacts.Hit(box))
+            {
+                const glm::vec2 normal(contacts.NormalX[box], contacts.NormalY[box]);
+                const glm::vec2 normalScalar(reference.NormalX[box], reference.NormalY[box]);
+                const glm::vec2 closest = glm::clamp(center, objects[box].Position, objects[box].Position + objects[box].Size);
+                const bool inside = closest == center;
+                if (normal != normalScalar || (!inside && VectorDirection(-normal) != std::get<1>(collision)))
+                    directionMismatches++;
+            }
+        }
+    }
+
+    std::cout << "COLLISIONBENCH: " << boxes << " boxes x " << circleCount << " circles; per box: CheckCollision " << single
+        << " ns, kernel scalar " << scalar << " ns (x" << single / scalar << "), kernel " << CollisionKernelName() << " " << kernel
+        << " ns (x" << single / kernel << "); hits " << hitsSingle << " / " << hitsScalar << " / " << hitsKernel << std::endl;
+    std::cout << "COLLISIONBENCH: " << hitMismatches << " hit and " << directionMismatches << " normal mismatches" << std::endl;
+    return hitMismatches + directionMismatches > 0 ? 1 : 0;
+}
+
+GLFWwindow* create_context(bool offscreen, int contextApi)
+{
+    if (offscreen)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit())
+    {
+        std::cout << "Failed to initialize GLFW" << std::endl;
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    glfwWindowHint(GLFW_RESIZABLE, false);
+    if (offscreen)
+    {
+        glfwWindowHint(GLFW_VISIBLE, false);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextApi);
+    }
+
+    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Breakout", nullptr, nullptr);
+    if (!window)
+    {
+        std::cout << "Failed to create GL context" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+
+    // OpenGL configuration
+    // --------------------
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glEnable(GL_BLEND);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return window;
+}
+
+int run_offscreen(unsigned int frames, const std::string &directory, unsigned int captureEvery, const std::string &goldenDirectory, int contextApi, unsigned int tickRate, bool software)
+{
+    if (!create_context(true, contextApi))
+        return -1;
+    std::filesystem::create_directories(directory);
+
+    NullAudio audio;
+    Breakout.Init(&audio, software ? static_cast<GameRenderer*>(&Software) : &Renderer);
+    int result = 0;
+    {
+        // the final image goes into the target instead of a (possibly missing) backbuffer
+        OffscreenTarget target(SCREEN_WIDTH, SCREEN_HEIGHT);
+        FramebufferBlit blit(SCREEN_WIDTH, SCREEN_HEIGHT);
+        blit.Output = target.FBO;
+        if (software)
+            Software.Presenter = &blit;
+        else
+            Renderer.SetOutput(target.FBO);
+
+        // scripted frames: the autopilot plays at the usual frame rate of simulated time
+        const float tickTime = 1.0f / tickRate;
+        const unsigned int ticksPerFrame = std::max(1u, tickRate / FPS);
+        std::vector<double> frameTimes;
+        unsigned int mismatches = 0;
+        for (unsigned int frame = 1; frame <= frames; ++frame)
+        {
+            for (unsigned int tick = 0; tick < ticksPerFrame; ++tick)
+            {
+                Breakout.AutoPlay();
+                Breakout.Tick(tickTime);
+            }
+            // time the whole frame up to the finished image
+            const auto start = std::chrono::steady_clock::now();
+            Breakout.Render();
+            glFinish();
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            GLState::NewFrame();
+            Shader::NewFrame();
+
+            if (frame != frames && (captureEvery == 0 || frame % captureEvery != 0))
+                continue;
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05u.png", frame);
+            const std::vector<unsigned char> pixels = target.ReadPixels();
+            OffscreenTarget::SavePNG(directory + "/" + name, target.Width, target.Height, pixels);
+            if (!goldenDirectory.empty())
+            {
+                const int differences = OffscreenTarget::ComparePNG(goldenDirectory + "/" + name, target.Width, target.Height, pixels, GOLDEN_TOLERANCE);
+                if (differences != 0)
+                {
+                    mismatches++;
+                    if (differences < 0)
+                        std::cout << "OFFSCREEN: " << name << ": no golden image of the same size" << std::endl;
+                    else
+                        std::cout << "OFFSCREEN: " << name << ": " << differences << " pixels differ from the golden image" << std::endl;
+                }
+            }
+        }
+
+        // report the frame time distribution
+        std::vector<double> sorted = frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double time : frameTimes)
+            total += time;
+        std::cout << "OFFSCREEN: " << frames << " frames, mean " << total / frames << " ms, median " << sorted[sorted.size() / 2]
+            << " ms, p95 " << sorted[sorted.size() * 95 / 100] << " ms, max " << sorted.back() << " ms ("
+            << frames * 1000.0 / total << " frames per second)" << std::endl;
+        if (!goldenDirectory.empty())
+            std::cout << "OFFSCREEN: " << mismatches << " images differ from the golden images" << std::endl;
+        result = mismatches > 0 ? 1 : 0;
+
+        Breakout.PrintStats();
+        Software.Presenter = nullptr;
+    }
+    ResourceManager::Clear();
+    glfwTerminate();
+    return result;
+}
@@ -0,0 +1,41 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "null_renderer.h"
+#include "game.h"
+
+#include <iostream>
+
+
+NullRenderer::NullRenderer()
+    : Frames(0), Commands(0)
+{
+
+}
+
+void NullRenderer::Init(unsigned int /*width*/, unsigned int /*height*/, AntiAliasing /*aa*/, ParticleBackend /*particles*/, unsigned int /*particleCount*/)
+{
+    // nothing to load; every sprite region stays empty
+}
+
+void NullRenderer::Draw(RenderSnapshot &frame)
+{
+    if (frame.Active)
+    {
+        frame.Queue.Sort();
+        this->Commands += frame.Queue.Size();
+        this->Frames++;
+    }
+    frame.Queue.Clear();
+}
+
+void NullRenderer::PrintStats()
+{
+    std::cout << "NULLRENDERER: " << this->Frames << " frames, "
+        << (this->Frames ? static_cast<double>(this->Commands) / this->Frames : 0.0) << " commands per frame" << std::endl;
+}
@@ -0,0 +1,33 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef NULL_RENDERER_H
+#define NULL_RENDERER_H
+
+#include "game_renderer.h"
+
+
+// NullRenderer consumes recorded frames without drawing anything. It
+// sorts every render queue like a real renderer would and keeps count
+// of the work, so the simulation can run (and be measured) on machines
+// without a display or GL context.
+class NullRenderer : public GameRenderer
+{
+public:
+    // frames and commands consumed so far
+    unsigned int       Frames;
+    unsigned long long Commands;
+    // constructor
+    NullRenderer();
+    void Init(unsigned int width, unsigned int height, AntiAliasing aa, ParticleBackend particles, unsigned int particleCount) override;
+    void Draw(RenderSnapshot &frame) override;
+    void PrintStats() override;
+    float GpuFrameTime() const override { return 0.0f; }
+};
+
+#endif
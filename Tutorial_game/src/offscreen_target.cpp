@@ -0,0 +1,94 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "offscreen_target.h"
+#include "gl_state.h"
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+
+OffscreenTarget::OffscreenTarget(unsigned int width, unsigned int height)
+    : Width(width), Height(height)
+{
+    // same color format as the multisampled scene, so it can be resolved straight into it
+    glGenRenderbuffers(1, &this->RBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, width, height);
+    glGenFramebuffers(1, &this->FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::OFFSCREEN: Failed to initialize FBO" << std::endl;
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    GLState::DeleteFramebuffer(this->FBO);
+    glDeleteRenderbuffers(1, &this->RBO);
+}
+
+std::vector<unsigned char> OffscreenTarget::ReadPixels() const
+{
+    std::vector<unsigned char> pixels(this->Width * this->Height * 4);
+    GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, this->FBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->Width, this->Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    // GL returns the bottom row first
+    const unsigned int stride = this->Width * 4;
+    std::vector<unsigned char> row(stride);
+    for (unsigned int y = 0; y < this->Height / 2; ++y)
+    {
+        unsigned char *top = &pixels[y * stride], *bottom = &pixels[(this->Height - 1 - y) * stride];
+        std::memcpy(row.data(), top, stride);
+        std::memcpy(top, bottom, stride);
+        std::memcpy(bottom, row.data(), stride);
+    }
+    return pixels;
+}
+
+bool OffscreenTarget::SavePNG(const std::string &file, unsigned int width, unsigned int height, const std::vector<unsigned char> &pixels)
+{
+    if (!stbi_write_png(file.c_str(), width, height, 4, pixels.data(), width * 4))
+    {
+        std::cout << "ERROR::OFFSCREEN: Failed to write " << file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int OffscreenTarget::ComparePNG(const std::string &file, unsigned int width, unsigned int height, const std::vector<unsigned char> &pixels, int tolerance)
+{
+    int goldenWidth, goldenHeight, channels;
+    unsigned char *golden = stbi_load(file.c_str(), &goldenWidth, &goldenHeight, &channels, 4);
+    if (!golden)
+        return -1;
+    int differences = -1;
+    if (goldenWidth == static_cast<int>(width) && goldenHeight == static_cast<int>(height))
+    {
+        differences = 0;
+        for (unsigned int i = 0; i < width * height; ++i)
+        {
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                if (std::abs(golden[i * 4 + c] - pixels[i * 4 + c]) > tolerance)
+                {
+                    differences++;
+                    break;
+                }
+            }
+        }
+    }
+    stbi_image_free(golden);
+    return differences;
+}
@@ -0,0 +1,41 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef OFFSCREEN_TARGET_H
+#define OFFSCREEN_TARGET_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// OffscreenTarget is a framebuffer the final image is rendered into
+// when there is no window (and possibly no default framebuffer at all,
+// as with surfaceless EGL contexts). Its contents can be read back and
+// saved as PNG or compared against a previously saved golden image.
+class OffscreenTarget
+{
+public:
+    // framebuffer to render into
+    unsigned int FBO;
+    unsigned int Width, Height;
+    // constructor/destructor (allocates an RGB color buffer of the given size)
+    OffscreenTarget(unsigned int width, unsigned int height);
+    ~OffscreenTarget();
+    // reads back the current contents as tightly packed RGBA rows, top row first (waits for the GPU)
+    std::vector<unsigned char> ReadPixels() const;
+    // writes RGBA pixels as PNG; returns false on failure
+    static bool SavePNG(const std::string &file, unsigned int width, unsigned int height, const std::vector<unsigned char> &pixels);
+    // number of pixels differing from the PNG in more than tolerance in any channel; -1 if it can't be loaded or the size differs
+    static int ComparePNG(const std::string &file, unsigned int width, unsigned int height, const std::vector<unsigned char> &pixels, int tolerance);
+private:
+    unsigned int RBO;
+};
+
+#endif
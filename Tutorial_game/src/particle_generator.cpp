@@ -7,60 +7,67 @@
 ** option) any later version.
 ******************************************************************/
 #include "particle_generator.h"
+#include "resource_manager.h"
+#include "gl_state.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
-    : shader(shader), texture(texture), amount(amount)
+#include <cstddef>
+
+ParticleGenerator::ParticleGenerator(Shader shader, TextureRegion texture, unsigned int amount, ParticleBackend backend)
+    : amount(amount), backend(backend), shader(shader), texture(texture), currentBuffer(0)
 {
     this->init();
+    if (this->backend == PARTICLES_GPU)
+        this->initGpu();
 }
 
-void ParticleGenerator::Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset)
+ParticleGenerator::~ParticleGenerator()
 {
-    // add new particles 
-    for (unsigned int i = 0; i < newParticles; ++i)
-    {
-        int unusedParticle = this->firstUnusedParticle();
-        this->respawnParticle(this->particles[unusedParticle], object, offset);
-    }
-    // update all particles
-    for (unsigned int i = 0; i < this->amount; ++i)
+    GLState::DeleteVertexArray(this->VAO);
+    glDeleteBuffers(1, &this->quadVBO);
+    glDeleteBuffers(1, &this->instanceVBO);
+    if (this->backend == PARTICLES_GPU)
     {
-        Particle &p = this->particles[i];
-        p.Life -= dt; // reduce life
-        if (p.Life > 0.0f)
-        {	// particle is alive, thus update
-            p.Position += p.Velocity * dt; 
-            p.Color.a -= dt * 2.5f;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            GLState::DeleteVertexArray(this->updateVAO[i]);
+            GLState::DeleteVertexArray(this->renderVAO[i]);
         }
+        glDeleteBuffers(2, this->stateVBO);
     }
 }
 
 // render all particles
-void ParticleGenerator::Draw()
+void ParticleGenerator::Draw(const ParticleFrame &frame)
 {
+    if (this->backend == PARTICLES_GPU)
+        this->simulateGpu(frame);
+    if (!frame.Visible)
+        return;
     // use additive blending to give it a 'glow' effect
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE);
     this->shader.Use();
-    this->texture.Bind();
-    glBindVertexArray(this->VAO);
-    for (const Particle particle : this->particles)
-    {
-        if (particle.Life > 0.0f)
-        {
-            this->shader.SetVector2f("offset", particle.Position);
-            this->shader.SetVector4f("color", particle.Color);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-        }
+    this->shader.Set(this->texRectUniform, this->texture.UV);
+    GLState::BindTexture(this->texture.ID, 0);
+    if (this->backend == PARTICLES_GPU)
+    {   // draw straight from the simulation buffer; dead particles are fully transparent
+        GLState::BindVertexArray(this->renderVAO[this->currentBuffer]);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, this->amount);
+        return;
     }
-    // don't forget to reset to default states
-    glBindVertexArray(0);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (frame.Instances.empty())
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->amount * sizeof(ParticleInstance), NULL, GL_STREAM_DRAW); // orphan last frame's data
+    glBufferSubData(GL_ARRAY_BUFFER, 0, frame.Instances.size() * sizeof(ParticleInstance), frame.Instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLState::BindVertexArray(this->VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, frame.Instances.size());
 }
 
 void ParticleGenerator::init()
 {
     // set up mesh and attribute properties
-    unsigned int VBO;
     const float particle_quad[] = {
         0.0f, 1.0f, 0.0f, 1.0f,
         1.0f, 0.0f, 1.0f, 0.0f,
@@ -71,51 +78,95 @@ void ParticleGenerator::init()
         1.0f, 0.0f, 1.0f, 0.0f
     }; 
     glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(this->VAO);
+    glGenBuffers(1, &this->quadVBO);
+    GLState::BindVertexArray(this->VAO);
     // fill mesh buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
     // set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
+    // per-instance offset and color of every live particle
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, this->amount * sizeof(ParticleInstance), NULL, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, Offset));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, Color));
+    glVertexAttribDivisor(2, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // create this->amount default particle instances
-    for (unsigned int i = 0; i < this->amount; ++i)
-        this->particles.push_back(Particle());
+    // resolve the uniforms used while drawing once
+    this->texRectUniform = this->shader.GetUniform<glm::vec4>("texRect");
 }
 
-// stores the index of the last particle used (for quick access to next dead particle)
-unsigned int ParticleGenerator::firstUnusedParticle()
+void ParticleGenerator::initGpu()
 {
-    static unsigned int lastUsedParticle = 0;
+    this->updateShader = ResourceManager::LoadFeedbackShader("assets/shaders/particle_update.vert",
+        { "outPosition", "outVelocity", "outColor", "outLife" }, "particle_update");
+    this->dtUniform = this->updateShader.GetUniform<float>("dt");
+    // the captured outputs are interleaved exactly like struct Particle
+    static_assert(sizeof(Particle) == 9 * sizeof(float), "Particle must be tightly packed to be used as GPU state");
+    // start with dead, invisible particles
+    Particle dead;
+    dead.Color = glm::vec4(0.0f);
+    std::vector<Particle> initial(this->amount, dead);
 
-    // first search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedParticle; i < this->amount; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedParticle; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
+    glGenBuffers(2, this->stateVBO);
+    glGenVertexArrays(2, this->updateVAO);
+    glGenVertexArrays(2, this->renderVAO);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, this->stateVBO[i]);
+        glBufferData(GL_ARRAY_BUFFER, this->amount * sizeof(Particle), initial.data(), GL_DYNAMIC_COPY);
+        // update pass reads the full state of every particle
+        GLState::BindVertexArray(this->updateVAO[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Velocity));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Color));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Life));
+        // rendering uses the quad plus position and color of every particle as instance data
+        GLState::BindVertexArray(this->renderVAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, this->stateVBO[i]);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Position));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, Color));
+        glVertexAttribDivisor(2, 1);
     }
-    // all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-    lastUsedParticle = 0;
-    return 0;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void ParticleGenerator::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
+void ParticleGenerator::simulateGpu(const ParticleFrame &frame)
 {
-    float random = ((rand() % 100) - 50) / 10.0f;
-    float rColor = 0.5f + ((rand() % 100) / 100.0f);
-    particle.Position = object.Position + random + offset;
-    particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-    particle.Life = 1.0f;
-    particle.Velocity = - glm::vec2(object.Velocity.x, object.Velocity.y) * 0.1f;
+    // write the spawned particles into the current state
+    glBindBuffer(GL_ARRAY_BUFFER, this->stateVBO[this->currentBuffer]);
+    for (const auto &spawn : frame.Spawns)
+        glBufferSubData(GL_ARRAY_BUFFER, spawn.first * sizeof(Particle), sizeof(Particle), &spawn.second);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (frame.Time <= 0.0f)
+        return;
+    // advance every particle into the other buffer; nothing is rasterized
+    const unsigned int next = 1 - this->currentBuffer;
+    this->updateShader.Use();
+    this->updateShader.Set(this->dtUniform, frame.Time);
+    glEnable(GL_RASTERIZER_DISCARD);
+    GLState::BindVertexArray(this->updateVAO[this->currentBuffer]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->stateVBO[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, this->amount);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    this->currentBuffer = next;
 }
@@ -14,47 +14,49 @@
 
 #include "shader.h"
 #include "texture.h"
-#include "game_object.h"
+#include "particle_system.h"
 
 #include <vector>
 
 
-// Represents a single particle and its state
-struct Particle {
-    glm::vec2 Position, Velocity;
-    glm::vec4 Color;
-    float     Life;
-
-    Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
-};
-
-
-// ParticleGenerator acts as a container for rendering a large number of 
-// particles by repeatedly spawning and updating particles and killing 
-// them after a given amount of time.
+// ParticleGenerator renders the particles of a ParticleSystem from the
+// ParticleFrames it records. All live particles are drawn with a single
+// instanced draw call.
+// With the GPU backend the particle state lives here: the recorded
+// spawns are written into the GPU state buffers and the whole system is
+// advanced by a transform feedback pass in Draw().
 class ParticleGenerator
 {
 public:
     // constructor
-    ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount);
-    // update all particles
-    void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
-    // render all particles
-    void Draw();
+    ParticleGenerator(Shader shader, TextureRegion texture, unsigned int amount, ParticleBackend backend = PARTICLES_CPU);
+    // destructor
+    ~ParticleGenerator();
+    // render all particles of a recorded frame
+    void Draw(const ParticleFrame &frame);
+    // texture the particles are drawn with
+    unsigned int TextureID() const { return this->texture.ID; }
 private:
     // state
-    std::vector<Particle> particles;
     unsigned int amount;
+    ParticleBackend backend;
     // render state
     Shader shader;
-    Texture2D texture;
-    unsigned int VAO;
+    TextureRegion texture;
+    unsigned int quadVBO, VAO, instanceVBO;
+    // GPU backend state: two particle buffers that are ping-ponged by the update pass
+    Shader updateShader;
+    unsigned int stateVBO[2], updateVAO[2], renderVAO[2];
+    unsigned int currentBuffer;
+    // pre-resolved uniforms
+    Uniform<glm::vec4> texRectUniform;
+    Uniform<float>     dtUniform;
     // initializes buffer and vertex attributes
     void init();
-    // returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-    unsigned int firstUnusedParticle();
-    // respawns particle
-    void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // creates the GPU particle buffers and the update shader
+    void initGpu();
+    // writes the recorded spawns into the GPU state and advances it by the recorded time
+    void simulateGpu(const ParticleFrame &frame);
 };
 
 #endif
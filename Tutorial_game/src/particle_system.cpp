@@ -0,0 +1,115 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "particle_system.h"
+
+#include <cstdlib>
+
+ParticleSystem::ParticleSystem(TextureRegion texture, unsigned int amount, ParticleBackend backend)
+    : amount(amount), lastUsedParticle(0), used(0), deadParticles(), backend(backend), texture(texture), pendingTime(0.0f)
+{
+    // create this->amount default particle instances
+    this->particles.resize(this->amount);
+}
+
+void ParticleSystem::Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset)
+{
+    // add new particles, then update all of them
+    this->Spawn(object, newParticles, offset);
+    this->Update(dt);
+}
+
+void ParticleSystem::Spawn(GameObject &object, unsigned int newParticles, glm::vec2 offset)
+{
+    if (this->backend == PARTICLES_GPU)
+    {
+        // only record what to spawn; the GPU applies it (and the elapsed time) when the frame is drawn.
+        // All particles live equally long, so the next slot of the ring is always the oldest one.
+        for (unsigned int i = 0; i < newParticles; ++i)
+        {
+            Particle particle;
+            this->respawnParticle(particle, object, offset);
+            this->spawns.push_back({ this->lastUsedParticle, particle });
+            this->lastUsedParticle = (this->lastUsedParticle + 1) % this->amount;
+        }
+        return;
+    }
+    for (unsigned int i = 0; i < newParticles; ++i)
+    {
+        int unusedParticle = this->firstUnusedParticle();
+        this->respawnParticle(this->particles[unusedParticle], object, offset);
+    }
+}
+
+void ParticleSystem::Update(float dt)
+{
+    if (this->backend == PARTICLES_GPU)
+    {
+        this->pendingTime += dt;
+        return;
+    }
+    // update all particles
+    for (unsigned int i = 0; i < this->used; ++i)
+    {
+        Particle &p = this->particles[i];
+        const bool wasAlive = p.Life > 0.0f;
+        p.Life -= dt; // reduce life
+        if (p.Life > 0.0f)
+        {	// particle is alive, thus update
+            p.Position += p.Velocity * dt; 
+            p.Color.a -= dt * 2.5f;
+        }
+        else if (wasAlive) // just died, free to respawn
+            this->deadParticles.push_back(i);
+    }
+}
+
+void ParticleSystem::Record(ParticleFrame &frame)
+{
+    if (this->backend == PARTICLES_GPU)
+    {   // hand over everything spawned and simulated since the last frame; slots are spawned into in
+        // turn, so only the last amount spawns can still be alive (each in a slot of its own)
+        if (this->spawns.size() > this->amount)
+            this->spawns.erase(this->spawns.begin(), this->spawns.end() - this->amount);
+        frame.Spawns.swap(this->spawns);
+        this->spawns.clear();
+        frame.Time = this->pendingTime;
+        this->pendingTime = 0.0f;
+        return;
+    }
+    // gather all live particles into the instance stream
+    frame.Instances.clear();
+    for (unsigned int i = 0; i < this->used; ++i)
+        if (this->particles[i].Life > 0.0f)
+            frame.Instances.push_back({ this->particles[i].Position, this->particles[i].Color });
+}
+
+unsigned int ParticleSystem::firstUnusedParticle()
+{
+    // reuse a particle that died; if none has, take one more from the rest of the pool
+    if (!this->deadParticles.empty())
+    {
+        const unsigned int particle = this->deadParticles.back();
+        this->deadParticles.pop_back();
+        return particle;
+    }
+    if (this->used < this->amount)
+        return this->used++;
+    // all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
+    return 0;
+}
+
+void ParticleSystem::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
+{
+    float random = ((rand() % 100) - 50) / 10.0f;
+    float rColor = 0.5f + ((rand() % 100) / 100.0f);
+    particle.Position = object.Position + random + offset;
+    particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
+    particle.Life = 1.0f;
+    particle.Velocity = - glm::vec2(object.Velocity.x, object.Velocity.y) * 0.1f;
+}
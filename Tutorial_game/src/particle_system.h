@@ -0,0 +1,95 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glm/glm.hpp>
+
+#include "sprite.h"
+#include "game_object.h"
+
+#include <vector>
+#include <utility>
+
+
+// Represents a single particle and its state
+struct Particle {
+    glm::vec2 Position, Velocity;
+    glm::vec4 Color;
+    float     Life;
+
+    Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
+};
+
+// Where particles are simulated
+enum ParticleBackend {
+    PARTICLES_CPU, // integrated on the CPU, live particles streamed to the GPU every frame
+    PARTICLES_GPU  // state lives in GPU buffers, advanced by a transform feedback pass
+};
+
+// Per-instance data of a live particle as streamed to the GPU
+struct ParticleInstance {
+    glm::vec2 Offset;
+    glm::vec4 Color;
+};
+
+// Everything a renderer needs from the simulation for one frame, so the
+// simulation can run ahead of (and on another thread than) rendering
+struct ParticleFrame {
+    std::vector<ParticleInstance>                  Instances; // CPU backend: live particles
+    std::vector<std::pair<unsigned int, Particle>> Spawns;    // GPU backend: slot and state of particles spawned since the last frame
+    float                                          Time = 0.0f; // GPU backend: simulation time not yet applied
+    bool                                           Visible = true; // whether to draw the particles (the GPU backend advances them either way)
+};
+
+
+// ParticleSystem holds the simulation side of a particle effect: it
+// repeatedly spawns and updates particles and kills them after a given
+// amount of time. It never touches GL; a ParticleGenerator draws the
+// ParticleFrames it records.
+// With the GPU backend only the spawned particles are recorded in
+// Update(); the renderer writes them into its GPU state buffers and
+// advances the whole system there.
+class ParticleSystem
+{
+public:
+    // constructor
+    ParticleSystem(TextureRegion texture, unsigned int amount, ParticleBackend backend = PARTICLES_CPU);
+    // update all particles
+    void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // spawns new particles at an object (e.g. one of several emitters sharing the system)
+    void Spawn(GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // advances all particles
+    void Update(float dt);
+    // moves the data of the current frame into the given ParticleFrame (has to happen every frame, drawn or not;
+    // with the GPU backend it holds at most one spawn per particle slot)
+    void Record(ParticleFrame &frame);
+    // texture the particles are drawn with
+    unsigned int TextureID() const { return this->texture.ID; }
+private:
+    // state
+    std::vector<Particle> particles;
+    unsigned int amount;
+    unsigned int lastUsedParticle; // GPU backend: the slot to spawn into next
+    // CPU backend: particles from the front of the pool ever spawned (only they are updated, so the pool
+    // can be sized for many emitters) and those of them that died since
+    unsigned int used;
+    std::vector<unsigned int> deadParticles;
+    ParticleBackend backend;
+    TextureRegion texture;
+    // GPU backend state
+    std::vector<std::pair<unsigned int, Particle>> spawns; // slot and state of particles spawned since the last Record()
+    float pendingTime;                                     // simulation time not yet recorded
+    // returns the index of a particle that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
+    unsigned int firstUnusedParticle();
+    // respawns particle
+    void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+};
+
+#endif
@@ -7,33 +7,185 @@
 ** option) any later version.
 ******************************************************************/
 #include "post_processor.h"
+#include "gl_state.h"
+#include "resource_manager.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 
-PostProcessor::PostProcessor(Shader shader, unsigned int width, unsigned int height) 
-    : PostProcessingShader(shader), Texture(), Width(width), Height(height), Confuse(false), Chaos(false), Shake(false)
+PostProcessor::PostProcessor(unsigned int width, unsigned int height, AntiAliasing aa) 
+    : Texture(), Width(width), Height(height), AA(AA_OFF), RenderScale(1.0f), Output(0), Confuse(false), Chaos(false), Shake(false), Timings(), LastFrameTime(0.0f), RBO(0), sceneWidth(width), sceneHeight(height), queryPending(), queryEffect(), queryMode(), currentQuery(0), frameEffects(0), effectFrame(false), passFrame(false)
 {
-    // initialize renderbuffer/framebuffer object
+    // initialize framebuffer objects; the multisampled storage depends on the anti-aliasing mode
     glGenFramebuffers(1, &this->MSFBO);
     glGenFramebuffers(1, &this->FBO);
-    glGenRenderbuffers(1, &this->RBO);
-    // initialize renderbuffer storage with a multisampled color buffer (don't need a depth/stencil buffer)
-    glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGB, width, height); // allocate storage for render buffer object
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO); // attach MS render buffer object to framebuffer
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::POSTPROCESSOR: Failed to initialize MSFBO" << std::endl;
+    this->SetAntiAliasing(aa);
     // also initialize the FBO/texture to blit multisampled color-buffer to; used for shader operations (for postprocessing effects)
-    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->FBO);
     this->Texture.Generate(width, height, NULL);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture.ID, 0); // attach texture to framebuffer as its color attachment
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "ERROR::POSTPROCESSOR: Failed to initialize FBO" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    // initialize render data and uniforms
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    // initialize render data and compile every effect combination up front so toggling never stalls
     this->initRenderData();
-    this->PostProcessingShader.SetInteger("scene", 0, true);
+    for (unsigned int effects = 1; effects < EFFECT_PERMUTATIONS; ++effects)
+        this->loadPermutation(effects);
+    glGenQueries(POSTPROCESS_QUERIES, this->queries);
+}
+
+void PostProcessor::SetAntiAliasing(AntiAliasing aa)
+{
+    this->AA = aa;
+    int samples = 0;
+    if (aa == AA_MSAA2)
+        samples = 2;
+    else if (aa == AA_MSAA4)
+        samples = 4;
+    else if (aa == AA_MSAA8)
+        samples = 8;
+    // without multisampling the scene is rendered single sampled; release the multisampled storage
+    if (samples == 0)
+    {
+        if (this->RBO != 0)
+            glDeleteRenderbuffers(1, &this->RBO);
+        this->RBO = 0;
+        return;
+    }
+    int maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    if (samples > maxSamples)
+    {
+        std::cout << "ERROR::POSTPROCESSOR: " << samples << "x MSAA not supported, using " << maxSamples << "x" << std::endl;
+        samples = maxSamples;
+    }
+    if (this->RBO == 0)
+        glGenRenderbuffers(1, &this->RBO);
+    // (re)allocate renderbuffer storage with a multisampled color buffer (don't need a depth/stencil buffer)
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->RBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGB, this->Width, this->Height); // allocate storage for render buffer object
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->RBO); // attach MS render buffer object to framebuffer
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::POSTPROCESSOR: Failed to initialize MSFBO" << std::endl;
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PostProcessor::SetRenderScale(float scale)
+{
+    this->RenderScale = std::clamp(scale, 0.1f, 1.0f);
+    this->sceneWidth = std::max(1u, static_cast<unsigned int>(this->Width * this->RenderScale + 0.5f));
+    this->sceneHeight = std::max(1u, static_cast<unsigned int>(this->Height * this->RenderScale + 0.5f));
+}
+
+void PostProcessor::BeginRender()
+{
+    this->BeginRender(this->EnabledEffects());
+}
+
+void PostProcessor::BeginRender(unsigned int effects)
+{
+    // time the whole frame, so the fill cost of multisampling is included
+    if (this->queryPending[this->currentQuery])
+        this->collectQuery(this->currentQuery);
+    glBeginQuery(GL_TIME_ELAPSED, this->queries[this->currentQuery]);
+    this->frameEffects = effects;
+    this->effectFrame = effects != 0;
+    this->passFrame = this->effectFrame || this->AA == AA_FXAA;
+    // render into the multisampled target, the pass texture or (with nothing to do afterwards) the backbuffer
+    const bool scaled = this->sceneWidth != this->Width || this->sceneHeight != this->Height;
+    if (this->RBO != 0)
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+    else
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, this->passFrame || scaled ? this->FBO : this->Output);
+    // a reduced scene only covers the lower left part of the targets
+    glViewport(0, 0, this->sceneWidth, this->sceneHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void PostProcessor::EndRender()
+{
+    const bool scaled = this->sceneWidth != this->Width || this->sceneHeight != this->Height;
+    if (this->RBO != 0)
+    {
+        // now resolve multisampled color-buffer into intermediate FBO to store to texture;
+        // without a pass to run it is resolved directly into the backbuffer instead
+        // (a multisample resolve can't scale, so a reduced scene always goes through the FBO)
+        GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
+        GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, this->passFrame || scaled ? this->FBO : this->Output);
+        glBlitFramebuffer(0, 0, this->sceneWidth, this->sceneHeight, 0, 0, this->sceneWidth, this->sceneHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    if (!this->passFrame && scaled)
+    {
+        // upscale the reduced scene into the backbuffer
+        GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, this->FBO);
+        GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, this->Output);
+        glBlitFramebuffer(0, 0, this->sceneWidth, this->sceneHeight, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->Output); // binds both READ and WRITE framebuffer to the output framebuffer
+    glViewport(0, 0, this->Width, this->Height);
+}
+
+void PostProcessor::Render(float time)
+{
+    if (this->passFrame)
+    {
+        // select the permutation of the active effects and set its uniforms
+        const unsigned int effects = this->frameEffects | (this->AA == AA_FXAA ? EFFECT_FXAA : 0);
+        Shader &shader = this->Permutations[effects];
+        shader.Use();
+        shader.Set(this->timeUniforms[effects], time);
+        shader.Set(this->uvScaleUniforms[effects], glm::vec2(this->sceneWidth, this->sceneHeight) / glm::vec2(this->Width, this->Height));
+        // render textured quad
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        this->Texture.Bind(0);
+        GLState::BindVertexArray(this->VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    this->queryPending[this->currentQuery] = true;
+    this->queryEffect[this->currentQuery] = this->effectFrame;
+    this->queryMode[this->currentQuery] = this->AA;
+    this->currentQuery = (this->currentQuery + 1) % POSTPROCESS_QUERIES;
+}
+
+unsigned int PostProcessor::EnabledEffects() const
+{
+    return (this->Chaos ? EFFECT_CHAOS : 0) | (this->Confuse ? EFFECT_CONFUSE : 0) | (this->Shake ? EFFECT_SHAKE : 0);
+}
+
+void PostProcessor::PrintTimings()
+{
+    for (unsigned int i = 0; i < POSTPROCESS_QUERIES; ++i)
+        if (this->queryPending[i])
+            this->collectQuery(i);
+    for (unsigned int mode = 0; mode < AA_MODES; ++mode)
+    {
+        const PostProcessTimings &t = this->Timings[mode];
+        if (t.IdleFrames + t.EffectFrames == 0)
+            continue;
+        std::cout << "POSTPROCESSOR: " << AntiAliasingName(static_cast<AntiAliasing>(mode))
+            << " idle frames: " << t.IdleFrames << ", avg " << (t.IdleFrames ? t.IdleTime / t.IdleFrames : 0.0) << " ms GPU"
+            << "; effect frames: " << t.EffectFrames << ", avg " << (t.EffectFrames ? t.EffectTime / t.EffectFrames : 0.0) << " ms GPU" << std::endl;
+    }
+}
+
+void PostProcessor::loadPermutation(unsigned int effects)
+{
+    std::string defines;
+    if (effects & EFFECT_CHAOS)
+        defines += "#define CHAOS\n";
+    if (effects & EFFECT_CONFUSE)
+        defines += "#define CONFUSE\n";
+    if (effects & EFFECT_SHAKE)
+        defines += "#define SHAKE\n";
+    if (effects & EFFECT_FXAA)
+        defines += "#define FXAA\n";
+    Shader &shader = this->Permutations[effects];
+    shader = ResourceManager::LoadShader("assets/shaders/effects.vert", "assets/shaders/effects.frag", nullptr, "effects_" + std::to_string(effects), defines);
+    shader.SetInteger("scene", 0, true);
     float offset = 1.0f / 300.0f;
     float offsets[9][2] = {
         { -offset,  offset  },  // top-left
@@ -46,51 +198,41 @@ PostProcessor::PostProcessor(Shader shader, unsigned int width, unsigned int hei
         {  0.0f,   -offset  },  // bottom-center
         {  offset, -offset  }   // bottom-right    
     };
-    glUniform2fv(glGetUniformLocation(this->PostProcessingShader.ID, "offsets"), 9, (float*)offsets);
+    // uniforms a permutation doesn't use are compiled out (location -1), which GL silently ignores
+    glUniform2fv(shader.GetUniformLocation("offsets"), 9, (float*)offsets);
     int edge_kernel[9] = {
         -1, -1, -1,
         -1,  8, -1,
         -1, -1, -1
     };
-    glUniform1iv(glGetUniformLocation(this->PostProcessingShader.ID, "edge_kernel"), 9, edge_kernel);
+    glUniform1iv(shader.GetUniformLocation("edge_kernel"), 9, edge_kernel);
     float blur_kernel[9] = {
         1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
         2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
         1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
     };
-    glUniform1fv(glGetUniformLocation(this->PostProcessingShader.ID, "blur_kernel"), 9, blur_kernel);    
-}
-
-void PostProcessor::BeginRender()
-{
-    glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-}
-
-void PostProcessor::EndRender()
-{
-    // now resolve multisampled color-buffer into intermediate FBO to store to texture
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
-    glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // binds both READ and WRITE framebuffer to default framebuffer
+    glUniform1fv(shader.GetUniformLocation("blur_kernel"), 9, blur_kernel);
+    this->timeUniforms[effects] = shader.GetUniform<float>("time");
+    this->uvScaleUniforms[effects] = shader.GetUniform<glm::vec2>("uvScale");
 }
 
-void PostProcessor::Render(float time)
+void PostProcessor::collectQuery(unsigned int index)
 {
-    // set uniforms/options
-    this->PostProcessingShader.Use();
-    this->PostProcessingShader.SetFloat("time", time);
-    this->PostProcessingShader.SetInteger("confuse", this->Confuse);
-    this->PostProcessingShader.SetInteger("chaos", this->Chaos);
-    this->PostProcessingShader.SetInteger("shake", this->Shake);
-    // render textured quad
-    glActiveTexture(GL_TEXTURE0);
-    this->Texture.Bind();
-    glBindVertexArray(this->VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    GLuint64 elapsed = 0; // nanoseconds
+    glGetQueryObjectui64v(this->queries[index], GL_QUERY_RESULT, &elapsed);
+    PostProcessTimings &timings = this->Timings[this->queryMode[index]];
+    this->LastFrameTime = elapsed / 1.0e6;
+    if (this->queryEffect[index])
+    {
+        timings.EffectTime += elapsed / 1.0e6;
+        timings.EffectFrames++;
+    }
+    else
+    {
+        timings.IdleTime += elapsed / 1.0e6;
+        timings.IdleFrames++;
+    }
+    this->queryPending[index] = false;
 }
 
 void PostProcessor::initRenderData()
@@ -113,9 +255,8 @@ void PostProcessor::initRenderData()
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->VAO);
+    GLState::BindVertexArray(this->VAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
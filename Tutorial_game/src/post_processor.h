@@ -15,38 +15,93 @@
 #include "texture.h"
 #include "sprite_renderer.h"
 #include "shader.h"
+#include "render_settings.h"
+
+
+// Number of compiled effect permutations (indexed by EffectBits)
+constexpr unsigned int EFFECT_PERMUTATIONS = 16;
+// Number of GPU timer queries in flight before results are read back
+constexpr unsigned int POSTPROCESS_QUERIES = 4;
+
+// GPU time spent rendering and presenting the scene, split by whether
+// any effect was active during the frame
+struct PostProcessTimings {
+    double       IdleTime = 0.0, EffectTime = 0.0; // milliseconds
+    unsigned int IdleFrames = 0, EffectFrames = 0;
+};
 
 
 // PostProcessor hosts all PostProcessing effects for the Breakout
 // Game. It renders the game on a textured quad after which one can
 // enable specific effects by enabling either the Confuse, Chaos or 
-// Shake boolean. 
+// Shake boolean. Every combination of effects is compiled into its
+// own shader permutation. The scene is anti-aliased according to the
+// selected AntiAliasing mode; when no pass is needed (no effect and no
+// FXAA) the scene ends up in the backbuffer directly, either through a
+// multisample resolve or by rendering into it in the first place.
+// The scene may be rendered at a fraction of the window resolution
+// (see SetRenderScale); it is then upscaled when presented.
+// Instead of the backbuffer the final image can go to any framebuffer
+// of the same size (see Output), e.g. when rendering offscreen.
 // It is required to call BeginRender() before rendering the game
 // and EndRender() after rendering the game for the class to work.
 class PostProcessor
 {
 public:
     // state
-    Shader PostProcessingShader;
+    Shader Permutations[EFFECT_PERMUTATIONS]; // indexed by EffectBits; 0 (no pass) is never used
     Texture2D Texture;
     unsigned int Width, Height;
+    AntiAliasing AA;
+    float RenderScale; // fraction of Width/Height the scene is rendered at
+    unsigned int Output; // framebuffer the final image ends up in (0 = backbuffer)
     // options
     bool Confuse, Chaos, Shake;
-    // constructor
-    PostProcessor(Shader shader, unsigned int width, unsigned int height);
+    // GPU timings of whole frames per anti-aliasing mode
+    PostProcessTimings Timings[AA_MODES];
+    float LastFrameTime; // most recent GPU frame time read back (milliseconds)
+    // constructor (loads the effect permutations and allocates the render targets of the given mode)
+    PostProcessor(unsigned int width, unsigned int height, AntiAliasing aa = AA_MSAA4);
+    // switches the anti-aliasing mode, reallocating the multisampled target as needed
+    void SetAntiAliasing(AntiAliasing aa);
+    // sets the internal scene resolution as a fraction of the window size; the targets keep their full size
+    void SetRenderScale(float scale);
     // prepares the postprocessor's framebuffer operations before rendering the game
     void BeginRender();
+    // same, with the effects (EffectBits) of this frame given explicitly instead of read from the options
+    void BeginRender(unsigned int effects);
     // should be called after rendering the game, so it stores all the rendered data into a texture object
     void EndRender();
     // renders the PostProcessor texture quad (as a screen-encompassing large sprite)
     void Render(float time);
+    // EffectBits of the currently enabled options
+    unsigned int EnabledEffects() const;
+    // prints the average GPU cost of idle and effect frames of every mode used
+    void PrintTimings();
 private:
     // render state
     unsigned int MSFBO, FBO; // MSFBO = Multisampled FBO. FBO is regular, used for blitting MS color-buffer to texture
-    unsigned int RBO; // RBO is used for multisampled color buffer
+    unsigned int RBO; // RBO is used for multisampled color buffer (only allocated in MSAA modes)
     unsigned int VAO;
+    // size of the scene as rendered with the current RenderScale
+    unsigned int sceneWidth, sceneHeight;
+    // pre-resolved per-frame uniforms of each permutation
+    Uniform<float>     timeUniforms[EFFECT_PERMUTATIONS];
+    Uniform<glm::vec2> uvScaleUniforms[EFFECT_PERMUTATIONS];
+    // GPU timer queries (ring buffer) with the mode and effect state each one timed
+    unsigned int queries[POSTPROCESS_QUERIES];
+    bool         queryPending[POSTPROCESS_QUERIES], queryEffect[POSTPROCESS_QUERIES];
+    AntiAliasing queryMode[POSTPROCESS_QUERIES];
+    unsigned int currentQuery;
+    // state of the current frame: effects enabled and whether the fullscreen pass runs
+    unsigned int frameEffects;
+    bool         effectFrame, passFrame;
     // initialize quad for rendering postprocessing texture
     void initRenderData();
+    // compiles the shader permutation for the given effect bits and sets its constant uniforms
+    void loadPermutation(unsigned int effects);
+    // accumulates the result of a finished timer query
+    void collectQuery(unsigned int index);
 };
 
 #endif
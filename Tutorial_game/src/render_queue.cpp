@@ -0,0 +1,125 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "render_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+
+// Bit layout of the sort key
+constexpr unsigned int KEY_SEQUENCE_BITS = 24;
+constexpr unsigned int KEY_BLEND_BITS    = 4;
+constexpr unsigned int KEY_TEXTURE_BITS  = 20;
+constexpr unsigned int KEY_PIPELINE_BITS = 8;
+constexpr unsigned int KEY_BLEND_SHIFT    = KEY_SEQUENCE_BITS;
+constexpr unsigned int KEY_TEXTURE_SHIFT  = KEY_BLEND_SHIFT + KEY_BLEND_BITS;
+constexpr unsigned int KEY_PIPELINE_SHIFT = KEY_TEXTURE_SHIFT + KEY_TEXTURE_BITS;
+constexpr unsigned int KEY_LAYER_SHIFT    = KEY_PIPELINE_SHIFT + KEY_PIPELINE_BITS;
+constexpr std::uint64_t KEY_SEQUENCE_MASK = (std::uint64_t(1) << KEY_SEQUENCE_BITS) - 1;
+
+static std::uint64_t keyField(std::uint64_t key, unsigned int shift, unsigned int bits)
+{
+    return (key >> shift) & ((std::uint64_t(1) << bits) - 1);
+}
+
+
+RenderQueue::RenderQueue(float viewWidth, float viewHeight)
+    : Stats(), view(viewWidth, viewHeight), culled(0)
+{
+
+}
+
+void RenderQueue::Clear()
+{
+    this->commands.clear();
+    this->keys.clear();
+    this->updates.clear();
+    this->bakes.clear();
+    this->culled = 0;
+}
+
+void RenderQueue::PushSprite(RenderLayer layer, const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    // conservative bounds: a sprite rotates around its center, so it stays within the circle through its corners
+    const glm::vec2 center = position + size * 0.5f;
+    const float radius = glm::length(size) * 0.5f;
+    if (size.x <= 0.0f || size.y <= 0.0f || center.x + radius < 0.0f || center.y + radius < 0.0f
+        || center.x - radius > this->view.x || center.y - radius > this->view.y)
+    {
+        this->culled++;
+        return;
+    }
+    RenderCommand command = { COMMAND_SPRITE, texture.ID, SpriteInstance::Make(texture, position, size, rotate, color), nullptr, nullptr };
+    this->push(layer, PIPELINE_SPRITE, BLEND_ALPHA, command);
+}
+
+void RenderQueue::PushSpriteBuffer(RenderLayer layer, const SpriteBuffer &buffer, unsigned int texture)
+{
+    RenderCommand command = { COMMAND_SPRITE_BUFFER, texture, SpriteInstance(), &buffer, nullptr };
+    this->push(layer, PIPELINE_SPRITE, BLEND_ALPHA, command);
+}
+
+void RenderQueue::PushParticles(RenderLayer layer, unsigned int texture, const ParticleFrame &frame)
+{
+    RenderCommand command = { COMMAND_PARTICLES, texture, SpriteInstance(), nullptr, &frame };
+    this->push(layer, PIPELINE_PARTICLE, BLEND_ADDITIVE, command);
+}
+
+void RenderQueue::PushBufferUpload(SpriteBuffer &buffer, std::vector<SpriteInstance> instances)
+{
+    this->updates.push_back({ &buffer, -1, std::move(instances) });
+}
+
+void RenderQueue::PushBufferPatch(SpriteBuffer &buffer, unsigned int index, const SpriteInstance &instance)
+{
+    this->updates.push_back({ &buffer, static_cast<int>(index), { instance } });
+}
+
+void RenderQueue::PushLayerBake(std::vector<StaticSprite> sprites)
+{
+    this->bakes.push_back({ std::move(sprites) });
+}
+
+void RenderQueue::PushStaticLayer(RenderLayer layer)
+{
+    RenderCommand command = { COMMAND_STATIC_LAYER, 0, SpriteInstance::Make(TextureRegion(), glm::vec2(0.0f), this->view), nullptr, nullptr };
+    this->push(layer, PIPELINE_SPRITE, BLEND_ALPHA, command);
+}
+
+void RenderQueue::Sort()
+{
+    // statistics of this frame (culling happened while recording)
+    this->Stats = RenderQueueStats();
+    this->Stats.Culled = this->culled;
+    this->Stats.Commands = this->commands.size();
+    std::sort(this->keys.begin(), this->keys.end());
+    // count the state changes between neighbouring commands
+    for (unsigned int i = 1; i < this->keys.size(); ++i)
+    {
+        const std::uint64_t key = this->keys[i], previous = this->keys[i - 1];
+        this->Stats.PipelineChanges += keyField(key, KEY_PIPELINE_SHIFT, KEY_PIPELINE_BITS) != keyField(previous, KEY_PIPELINE_SHIFT, KEY_PIPELINE_BITS);
+        this->Stats.TextureChanges += keyField(key, KEY_TEXTURE_SHIFT, KEY_TEXTURE_BITS) != keyField(previous, KEY_TEXTURE_SHIFT, KEY_TEXTURE_BITS);
+        this->Stats.BlendChanges += keyField(key, KEY_BLEND_SHIFT, KEY_BLEND_BITS) != keyField(previous, KEY_BLEND_SHIFT, KEY_BLEND_BITS);
+    }
+}
+
+const RenderCommand &RenderQueue::Command(unsigned int index) const
+{
+    return this->commands[this->keys[index] & KEY_SEQUENCE_MASK];
+}
+
+void RenderQueue::push(RenderLayer layer, RenderPipeline pipeline, BlendMode blend, const RenderCommand &command)
+{
+    const std::uint64_t sequence = this->commands.size() & KEY_SEQUENCE_MASK;
+    const std::uint64_t texture = command.Texture & ((std::uint64_t(1) << KEY_TEXTURE_BITS) - 1);
+    this->keys.push_back(
+        (std::uint64_t(layer) << KEY_LAYER_SHIFT) | (std::uint64_t(pipeline) << KEY_PIPELINE_SHIFT) |
+        (texture << KEY_TEXTURE_SHIFT) | (std::uint64_t(blend) << KEY_BLEND_SHIFT) | sequence);
+    this->commands.push_back(command);
+}
@@ -0,0 +1,139 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sprite.h"
+
+struct ParticleFrame;
+
+
+// Draw order of the scene; lower layers are drawn first
+enum RenderLayer {
+    LAYER_BACKGROUND,
+    LAYER_LEVEL,
+    LAYER_POWERUPS,
+    LAYER_PLAYER,
+    LAYER_PARTICLES,
+    LAYER_BALL
+};
+
+// Shader program (and vertex layout) a command is drawn with
+enum RenderPipeline {
+    PIPELINE_SPRITE,
+    PIPELINE_PARTICLE
+};
+
+// Blend state a command is drawn with
+enum BlendMode {
+    BLEND_ALPHA,   // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    BLEND_ADDITIVE // GL_SRC_ALPHA, GL_ONE
+};
+
+// What a command draws
+enum RenderCommandType {
+    COMMAND_SPRITE,        // a single sprite instance
+    COMMAND_SPRITE_BUFFER, // a GPU resident SpriteBuffer
+    COMMAND_PARTICLES,     // all live particles of a ParticleSystem
+    COMMAND_STATIC_LAYER   // the renderer's static layer, covering the whole view
+};
+
+// A recorded draw. Commands only hold data (or point at resources that
+// outlive the frame); what they mean to the GPU is up to the renderer.
+struct RenderCommand {
+    RenderCommandType   Type;
+    unsigned int        Texture;
+    SpriteInstance      Instance;     // COMMAND_SPRITE, COMMAND_STATIC_LAYER (UVs up to the renderer)
+    const SpriteBuffer  *Buffer;       // COMMAND_SPRITE_BUFFER
+    const ParticleFrame *ParticleData; // COMMAND_PARTICLES
+};
+
+// A recorded change of a GPU resident SpriteBuffer, applied before any
+// command of the frame is drawn
+struct BufferUpdate {
+    SpriteBuffer               *Buffer;
+    int                         Index;     // instance to overwrite; -1 replaces the whole buffer
+    std::vector<SpriteInstance> Instances;
+};
+
+// A recorded re-bake of the renderer's static layer
+struct LayerBake {
+    std::vector<StaticSprite> Sprites;
+};
+
+// Work done by the last sorted frame
+struct RenderQueueStats {
+    unsigned int Commands = 0;        // recorded (after culling)
+    unsigned int Culled = 0;          // sprites rejected as off-screen
+    unsigned int DrawCalls = 0;       // filled in by the renderer
+    unsigned int PipelineChanges = 0;
+    unsigned int TextureChanges = 0;
+    unsigned int BlendChanges = 0;
+};
+
+
+// RenderQueue collects the draw commands of a frame and submits them
+// ordered by a packed 64-bit sort key:
+//   <layer:8 | pipeline:8 | texture:20 | blend:4 | sequence:24>
+// Layers keep their painter's order; within a layer commands are
+// grouped by shader, texture and blend state so a renderer can batch
+// them. The sequence (the command's index) keeps the sort stable and
+// doubles as the lookup from key to command.
+// The queue never touches GL: it is filled by the simulation (possibly
+// on another thread) and a renderer applies the recorded updates and
+// bakes, sorts it and walks the commands in draw order.
+class RenderQueue
+{
+public:
+    // statistics of the last Sort()
+    RenderQueueStats Stats;
+    // constructor (sprites outside of the given view are culled)
+    RenderQueue(float viewWidth, float viewHeight);
+    // drops all recorded commands
+    void Clear();
+    // records a sprite
+    void PushSprite(RenderLayer layer, const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // records a GPU resident sprite buffer
+    void PushSpriteBuffer(RenderLayer layer, const SpriteBuffer &buffer, unsigned int texture);
+    // records the particles of a system (drawn with additive blending); the frame data has to outlive the draw
+    void PushParticles(RenderLayer layer, unsigned int texture, const ParticleFrame &frame);
+    // records the (re)upload of a whole sprite buffer
+    void PushBufferUpload(SpriteBuffer &buffer, std::vector<SpriteInstance> instances);
+    // records the change of a single instance of a sprite buffer
+    void PushBufferPatch(SpriteBuffer &buffer, unsigned int index, const SpriteInstance &instance);
+    // records a re-bake of the static layer (done before anything of the frame is drawn)
+    void PushLayerBake(std::vector<StaticSprite> sprites);
+    // records the static layer as a sprite covering the whole view
+    void PushStaticLayer(RenderLayer layer);
+    // sorts the recorded commands into draw order and updates Stats (except DrawCalls)
+    void Sort();
+    // number of recorded commands
+    unsigned int Size() const { return this->keys.size(); }
+    // the index-th command in draw order (after Sort())
+    const RenderCommand &Command(unsigned int index) const;
+    // recorded static layer bakes and buffer changes, in recording order
+    const std::vector<LayerBake> &Bakes() const { return this->bakes; }
+    const std::vector<BufferUpdate> &Updates() const { return this->updates; }
+private:
+    glm::vec2                  view;
+    std::vector<RenderCommand> commands;
+    std::vector<std::uint64_t> keys;
+    std::vector<BufferUpdate>  updates;
+    std::vector<LayerBake>     bakes;
+    unsigned int               culled;
+    // records a command under the given sort key fields
+    void push(RenderLayer layer, RenderPipeline pipeline, BlendMode blend, const RenderCommand &command);
+};
+
+#endif
@@ -0,0 +1,39 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_SETTINGS_H
+#define RENDER_SETTINGS_H
+
+
+// Anti-aliasing strategy of the scene render target
+enum AntiAliasing {
+    AA_OFF,
+    AA_MSAA2,
+    AA_MSAA4,
+    AA_MSAA8,
+    AA_FXAA   // single sampled target, smoothed in the fullscreen pass
+};
+constexpr unsigned int AA_MODES = 5;
+
+// Post-processing effects of a frame; also the bits selecting a compiled
+// effect permutation of the PostProcessor
+enum EffectBits {
+    EFFECT_CHAOS   = 1,
+    EFFECT_CONFUSE = 2,
+    EFFECT_SHAKE   = 4,
+    EFFECT_FXAA    = 8
+};
+
+// name of an anti-aliasing mode as used on the command line
+inline const char *AntiAliasingName(AntiAliasing aa)
+{
+    static const char *names[AA_MODES] = { "off", "msaa2", "msaa4", "msaa8", "fxaa" };
+    return names[aa];
+}
+
+#endif
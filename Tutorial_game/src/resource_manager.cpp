@@ -7,24 +7,45 @@
 ** option) any later version.
 ******************************************************************/
 #include "resource_manager.h"
+#include "gl_state.h"
 
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 
 #include <stb_image.h>
 
 // Instantiate static variables
 std::unordered_map<std::string, Texture2D>    ResourceManager::Textures;
 std::unordered_map<std::string, Shader>       ResourceManager::Shaders;
+std::vector<ResourceManager::AtlasImage>       ResourceManager::atlasQueue;
 
+// Empty border around every atlas entry; filled with the entry's edge pixels so linear filtering never bleeds
+constexpr int ATLAS_PADDING = 2;
 
-Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
+
+Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name, const std::string &defines)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile, defines);
     return Shaders[name];
 }
 
+Shader ResourceManager::LoadFeedbackShader(const char *vShaderFile, std::vector<const char *> varyings, std::string name)
+{
+    std::ifstream vertexShaderFile(vShaderFile);
+    std::stringstream vShaderStream;
+    vShaderStream << vertexShaderFile.rdbuf();
+    if (!vertexShaderFile)
+        std::cout << "ERROR::SHADER: Failed to read shader file: " << vShaderFile << std::endl;
+    const std::string vertexCode = vShaderStream.str();
+    Shader shader;
+    shader.CompileFeedback(vertexCode.c_str(), varyings);
+    Shaders[name] = shader;
+    return shader;
+}
+
 Shader ResourceManager::GetShader(std::string name)
 {
     return Shaders[name];
@@ -41,17 +62,166 @@ Texture2D &ResourceManager::GetTexture(std::string name)
     return Textures[name];
 }
 
+void ResourceManager::AddToAtlas(const char *file, bool alpha, std::string name)
+{
+    // always load as RGBA so all entries share the atlas' pixel format
+    int width, height, nrChannels;
+    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 4);
+    if (!data)
+    {
+        std::cout << "ERROR::ATLAS: Failed to load image: " << file << std::endl;
+        return;
+    }
+    if (!alpha)
+        for (int i = 0; i < width * height; ++i)
+            data[i * 4 + 3] = 255;
+    atlasQueue.push_back({ name, width, height, data });
+}
+
+void ResourceManager::BuildAtlas(std::string name, unsigned int pageSize)
+{
+    int maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    const int size = std::min(static_cast<int>(pageSize), maxSize);
+    // pack tallest images first so the shelves stay tight
+    std::sort(atlasQueue.begin(), atlasQueue.end(),
+        [](const AtlasImage &a, const AtlasImage &b) { return a.Height > b.Height; });
+
+    // 1. assign every image a page and a position using first-fit shelf packing
+    struct Shelf { int Y, Height, Width; };
+    struct Placement { unsigned int Page; int X, Y; };
+    std::vector<std::vector<Shelf>> pages(1);
+    std::vector<int> pageHeights(1, 0);
+    std::vector<Placement> placements;
+    for (const AtlasImage &image : atlasQueue)
+    {
+        const int w = image.Width + 2 * ATLAS_PADDING;
+        const int h = image.Height + 2 * ATLAS_PADDING;
+        if (w > size || h > size)
+        {
+            std::cout << "ERROR::ATLAS: Image does not fit into an atlas page: " << image.Name << std::endl;
+            placements.push_back({ 0, -1, -1 });
+            continue;
+        }
+        bool placed = false;
+        for (unsigned int p = 0; p < pages.size() && !placed; ++p)
+        {
+            for (Shelf &shelf : pages[p])
+            {
+                if (shelf.Height >= h && shelf.Width + w <= size)
+                {
+                    placements.push_back({ p, shelf.Width, shelf.Y });
+                    shelf.Width += w;
+                    placed = true;
+                    break;
+                }
+            }
+        }
+        if (!placed)
+        {
+            // open a new shelf on the last page, or start a new page if it is full
+            if (pageHeights.back() + h > size)
+            {
+                pages.emplace_back();
+                pageHeights.push_back(0);
+            }
+            const unsigned int p = pages.size() - 1;
+            pages[p].push_back({ pageHeights[p], h, w });
+            placements.push_back({ p, 0, pageHeights[p] });
+            pageHeights[p] += h;
+        }
+    }
+
+    // 2. copy the images (plus extruded borders) into the pages and upload them
+    for (unsigned int p = 0; p < pages.size(); ++p)
+    {
+        // only allocate as many rows as the shelves actually use
+        const int height = pageHeights[p];
+        if (height == 0)
+            continue;
+        std::vector<unsigned char> pixels(size * height * 4, 0);
+        for (unsigned int i = 0; i < atlasQueue.size(); ++i)
+        {
+            const AtlasImage &image = atlasQueue[i];
+            const Placement &place = placements[i];
+            if (place.Page != p || place.X < 0)
+                continue;
+            for (int y = -ATLAS_PADDING; y < image.Height + ATLAS_PADDING; ++y)
+            {
+                const int srcY = std::clamp(y, 0, image.Height - 1);
+                for (int x = -ATLAS_PADDING; x < image.Width + ATLAS_PADDING; ++x)
+                {
+                    const int srcX = std::clamp(x, 0, image.Width - 1);
+                    const int dstX = place.X + ATLAS_PADDING + x;
+                    const int dstY = place.Y + ATLAS_PADDING + y;
+                    std::memcpy(&pixels[(dstY * size + dstX) * 4], &image.Data[(srcY * image.Width + srcX) * 4], 4);
+                }
+            }
+        }
+        Texture2D page;
+        page.Internal_Format = GL_RGBA;
+        page.Image_Format = GL_RGBA;
+        page.Wrap_S = GL_CLAMP_TO_EDGE;
+        page.Wrap_T = GL_CLAMP_TO_EDGE;
+        page.Generate(size, height, pixels.data());
+        Textures[name + "_" + std::to_string(p)] = page;
+
+        // register the UV range of every image on this page
+        for (unsigned int i = 0; i < atlasQueue.size(); ++i)
+        {
+            const AtlasImage &image = atlasQueue[i];
+            const Placement &place = placements[i];
+            if (place.Page != p || place.X < 0)
+                continue;
+            SpriteRegistry::Regions[image.Name] = TextureRegion(page.ID, glm::vec4(
+                static_cast<float>(place.X + ATLAS_PADDING) / size,
+                static_cast<float>(place.Y + ATLAS_PADDING) / height,
+                static_cast<float>(image.Width) / size,
+                static_cast<float>(image.Height) / height));
+        }
+    }
+    // and finally free image data
+    for (AtlasImage &image : atlasQueue)
+        stbi_image_free(image.Data);
+    atlasQueue.clear();
+}
+
+TextureRegion ResourceManager::GetRegion(std::string name)
+{
+    auto region = SpriteRegistry::Regions.find(name);
+    if (region != SpriteRegistry::Regions.end())
+        return region->second;
+    return TextureRegion(GetTexture(name));
+}
+
 void ResourceManager::Clear()
 {
     // (properly) delete all shaders	
     for (auto iter : Shaders)
-        glDeleteProgram(iter.second.ID);
+        GLState::DeleteProgram(iter.second.ID);
     // (properly) delete all textures
     for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
+        GLState::DeleteTexture(iter.second.ID);
+    SpriteRegistry::Regions.clear();
+}
+
+// Inserts the given preprocessor lines right after the #version directive (which has to stay first)
+static void injectDefines(std::string &code, const std::string &defines)
+{
+    if (defines.empty())
+        return;
+    std::size_t position = code.find("#version");
+    if (position == std::string::npos)
+        position = 0;
+    else
+    {
+        position = code.find('\n', position);
+        position = position == std::string::npos ? code.size() : position + 1;
+    }
+    code.insert(position, defines);
 }
 
-Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile)
+Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, const std::string &defines)
 {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -86,6 +256,9 @@ Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *
     {
         std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
     }
+    injectDefines(vertexCode, defines);
+    injectDefines(fragmentCode, defines);
+    injectDefines(geometryCode, defines);
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
     const char *gShaderCode = geometryCode.c_str();
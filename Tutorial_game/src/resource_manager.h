@@ -11,40 +11,59 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <miniaudio.h>
 
 #include "texture.h"
 #include "shader.h"
+#include "sprite.h"
 
 
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
 // and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
-// public constructor is defined.
+// handles. Small sprite images can instead be packed into shared
+// atlas pages and referenced as TextureRegions. All functions and
+// resources are static and no public constructor is defined.
 class ResourceManager
 {
 public:
     // resource storage
     static std::unordered_map<std::string, Shader>    Shaders;
     static std::unordered_map<std::string, Texture2D> Textures;
-    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader    LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
+    // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader.
+    // Optional defines (e.g. "#define CHAOS\n") are inserted after the #version line of every stage to compile a permutation
+    static Shader    LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name, const std::string &defines = "");
+    // loads (and generates) a vertex-only shader program whose given outputs are captured with transform feedback
+    static Shader    LoadFeedbackShader(const char *vShaderFile, std::vector<const char *> varyings, std::string name);
     // retrieves a stored sader
     static Shader    GetShader(std::string name);
     // loads (and generates) a texture from file
     static Texture2D LoadTexture(const char *file, bool alpha, std::string name);
     // retrieves a stored texture
     static Texture2D &GetTexture(std::string name);
+    // queues an image to be packed into the next atlas built by BuildAtlas
+    static void      AddToAtlas(const char *file, bool alpha, std::string name);
+    // packs all queued images into atlas pages (stored as textures "name_0", "name_1", ...) and registers a region per image in the SpriteRegistry
+    static void      BuildAtlas(std::string name, unsigned int pageSize = 2048);
+    // retrieves a stored texture region; falls back to the whole texture of the same name
+    static TextureRegion GetRegion(std::string name);
     // properly de-allocates all loaded resources
     static void      Clear();
 private:
+    // image waiting to be packed into an atlas
+    struct AtlasImage {
+        std::string    Name;
+        int            Width, Height;
+        unsigned char *Data; // RGBA pixels
+    };
+    static std::vector<AtlasImage> atlasQueue;
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
     // loads and generates a shader from file
-    static Shader    loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr);
+    static Shader    loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr, const std::string &defines = "");
     // loads a single texture from file
     static Texture2D loadTextureFromFile(const char *file, bool alpha);
 };
@@ -9,10 +9,25 @@
 #include <iostream>
 
 #include "shader.h"
+#include "gl_state.h"
+
+#include <vector>
+
+unsigned int Shader::LocationLookups = 0;
+unsigned int Shader::DriverLookups = 0;
+unsigned int Shader::LastFrameLookups = 0;
+unsigned int Shader::LastFrameDriverLookups = 0;
+
+void Shader::NewFrame()
+{
+    LastFrameLookups = LocationLookups;
+    LastFrameDriverLookups = DriverLookups;
+    LocationLookups = DriverLookups = 0;
+}
 
 Shader &Shader::Use()
 {
-    glUseProgram(this->ID);
+    GLState::UseProgram(this->ID);
     return *this;
 }
 
@@ -45,6 +60,7 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
         glAttachShader(this->ID, gShader);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    this->cacheUniformLocations();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
@@ -56,57 +72,132 @@ void Shader::SetFloat(const char *name, float value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    glUniform1f(this->GetUniformLocation(name), value);
 }
 void Shader::SetInteger(const char *name, int value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    glUniform1i(this->GetUniformLocation(name), value);
 }
 void Shader::SetVector2f(const char *name, float x, float y, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    glUniform2f(this->GetUniformLocation(name), x, y);
 }
 void Shader::SetVector2f(const char *name, const glm::vec2 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform2f(this->GetUniformLocation(name), value.x, value.y);
 }
 void Shader::SetVector3f(const char *name, float x, float y, float z, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform3f(this->GetUniformLocation(name), x, y, z);
 }
 void Shader::SetVector3f(const char *name, const glm::vec3 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform3f(this->GetUniformLocation(name), value.x, value.y, value.z);
 }
 void Shader::SetVector4f(const char *name, float x, float y, float z, float w, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform4f(this->GetUniformLocation(name), x, y, z, w);
 }
 void Shader::SetVector4f(const char *name, const glm::vec4 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(this->GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
 void Shader::SetMatrix4(const char *name, const glm::mat4 &matrix, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    glUniformMatrix4fv(this->GetUniformLocation(name), 1, false, glm::value_ptr(matrix));
+}
+
+void Shader::CompileFeedback(const char *vertexSource, const std::vector<const char *> &varyings)
+{
+    unsigned int sVertex;
+    // vertex Shader
+    sVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(sVertex, 1, &vertexSource, NULL);
+    glCompileShader(sVertex);
+    checkCompileErrors(sVertex, "VERTEX");
+    // shader program; the captured outputs have to be declared before linking
+    this->ID = glCreateProgram();
+    glAttachShader(this->ID, sVertex);
+    glTransformFeedbackVaryings(this->ID, varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(this->ID);
+    checkCompileErrors(this->ID, "PROGRAM");
+    this->cacheUniformLocations();
+    glDeleteShader(sVertex);
+}
+
+int Shader::GetUniformLocation(const char *name) const
+{
+    LocationLookups++;
+    auto location = this->uniformLocations.find(name);
+    if (location != this->uniformLocations.end())
+        return location->second;
+    // not an active uniform (e.g. optimized out by the GLSL compiler)
+    return -1;
 }
 
+void Shader::Set(Uniform<float> uniform, float value)
+{
+    glUniform1f(uniform.Location, value);
+}
+void Shader::Set(Uniform<int> uniform, int value)
+{
+    glUniform1i(uniform.Location, value);
+}
+void Shader::Set(Uniform<glm::vec2> uniform, const glm::vec2 &value)
+{
+    glUniform2f(uniform.Location, value.x, value.y);
+}
+void Shader::Set(Uniform<glm::vec3> uniform, const glm::vec3 &value)
+{
+    glUniform3f(uniform.Location, value.x, value.y, value.z);
+}
+void Shader::Set(Uniform<glm::vec4> uniform, const glm::vec4 &value)
+{
+    glUniform4f(uniform.Location, value.x, value.y, value.z, value.w);
+}
+void Shader::Set(Uniform<glm::mat4> uniform, const glm::mat4 &matrix)
+{
+    glUniformMatrix4fv(uniform.Location, 1, false, glm::value_ptr(matrix));
+}
+
+void Shader::cacheUniformLocations()
+{
+    this->uniformLocations.clear();
+    int count = 0, maxLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(maxLength + 1);
+    for (int i = 0; i < count; ++i)
+    {
+        int length, size;
+        unsigned int type;
+        glGetActiveUniform(this->ID, i, name.size(), &length, &size, &type, name.data());
+        std::string uniformName(name.data(), length);
+        const int location = glGetUniformLocation(this->ID, uniformName.c_str());
+        DriverLookups++;
+        this->uniformLocations[uniformName] = location;
+        // arrays are reported as "name[0]"; also make them available by their plain name
+        const std::size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+            this->uniformLocations[uniformName.substr(0, bracket)] = location;
+    }
+}
 
 void Shader::checkCompileErrors(unsigned int object, std::string type)
 {
@@ -10,26 +10,47 @@
 #define SHADER_H
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 
+// Pre-resolved handle to a uniform of a linked program. The template
+// argument is the uniform's GLSL type and picks the matching Set overload.
+template <typename T>
+struct Uniform {
+    int Location = -1;
+};
+
+
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
-// functions for easy management.
+// functions for easy management. All active uniform locations are
+// resolved once at link time; hot paths should use Uniform handles.
 class Shader
 {
 public:
     // state
     unsigned int ID; 
+    // number of uniform locations resolved by name (from the cache or the driver)
+    static unsigned int LocationLookups;
+    // number of glGetUniformLocation calls issued to the driver
+    static unsigned int DriverLookups;
+    // the same numbers for the last completed frame (hot paths should keep both at 0)
+    static unsigned int LastFrameLookups, LastFrameDriverLookups;
+    // closes the lookup statistics of the current frame
+    static void NewFrame();
     // constructor
     Shader() { }
     // sets the current shader as active
     Shader  &Use();
     // compiles the shader from given source code
     void    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr); // note: geometry source code is optional 
+    // compiles a vertex-only program whose outputs are captured (interleaved) with transform feedback
+    void    CompileFeedback(const char *vertexSource, const std::vector<const char *> &varyings);
     // utility functions
     void    SetFloat    (const char *name, float value, bool useShader = false);
     void    SetInteger  (const char *name, int value, bool useShader = false);
@@ -40,9 +61,25 @@ public:
     void    SetVector4f (const char *name, float x, float y, float z, float w, bool useShader = false);
     void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false);
     void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false);
+    // returns the location of the given uniform (-1 if it is not active)
+    int     GetUniformLocation(const char *name) const;
+    // returns a handle to the given uniform that can be set without any lookup
+    template <typename T>
+    Uniform<T> GetUniform(const char *name) const { return Uniform<T>{ this->GetUniformLocation(name) }; }
+    // set a uniform through a pre-resolved handle (the shader must be in use)
+    void    Set(Uniform<float> uniform, float value);
+    void    Set(Uniform<int> uniform, int value);
+    void    Set(Uniform<glm::vec2> uniform, const glm::vec2 &value);
+    void    Set(Uniform<glm::vec3> uniform, const glm::vec3 &value);
+    void    Set(Uniform<glm::vec4> uniform, const glm::vec4 &value);
+    void    Set(Uniform<glm::mat4> uniform, const glm::mat4 &matrix);
 private:
+    // uniform name -> location of all active uniforms, filled in at link time
+    std::unordered_map<std::string, int> uniformLocations;
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type); 
+    // introspects the linked program and caches the location of every active uniform
+    void    cacheUniformLocations();
 };
 
 #endif
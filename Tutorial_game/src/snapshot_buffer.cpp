@@ -0,0 +1,58 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "snapshot_buffer.h"
+
+
+SnapshotBuffer::SnapshotBuffer(float width, float height)
+    : slots{ RenderSnapshot(width, height), RenderSnapshot(width, height), RenderSnapshot(width, height) },
+      writing(0), ready(-1), rendering(-1), closed(false)
+{
+
+}
+
+RenderSnapshot &SnapshotBuffer::WriteSlot()
+{
+    // only the game thread changes which slot is written
+    return this->slots[this->writing];
+}
+
+void SnapshotBuffer::Publish()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->changed.wait(lock, [this] { return this->ready < 0 || this->closed; });
+    if (this->closed)
+        return;
+    this->ready = this->writing;
+    // continue with the slot that is neither waiting nor being drawn
+    for (int slot = 0; slot < 3; ++slot)
+        if (slot != this->ready && slot != this->rendering)
+            this->writing = slot;
+    this->changed.notify_all();
+}
+
+RenderSnapshot *SnapshotBuffer::Acquire()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    // taking a new slot implies the previously drawn one is free again
+    this->rendering = -1;
+    this->changed.wait(lock, [this] { return this->ready >= 0 || this->closed; });
+    if (this->ready < 0)
+        return nullptr;
+    this->rendering = this->ready;
+    this->ready = -1;
+    this->changed.notify_all();
+    return &this->slots[this->rendering];
+}
+
+void SnapshotBuffer::Close()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->closed = true;
+    this->changed.notify_all();
+}
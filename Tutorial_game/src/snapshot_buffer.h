@@ -0,0 +1,46 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include <mutex>
+#include <condition_variable>
+
+#include "game.h"
+
+
+// SnapshotBuffer hands RenderSnapshots from the game thread to the
+// render thread. Of its three slots one is being recorded, one is
+// waiting to be drawn and one is being drawn, so recording frame N+1
+// overlaps drawing frame N. Snapshots carry incremental changes (e.g.
+// patched bricks, spawned GPU particles) and are therefore never
+// dropped: Publish() waits while the previous snapshot hasn't been
+// picked up yet.
+class SnapshotBuffer
+{
+public:
+    // constructor (sizes the render queues' culling view)
+    SnapshotBuffer(float width, float height);
+    // game thread: the slot to record the next frame into
+    RenderSnapshot &WriteSlot();
+    // game thread: hands the recorded slot over to the render thread
+    void Publish();
+    // render thread: waits for the next published snapshot; returns nullptr once closed
+    RenderSnapshot *Acquire();
+    // wakes up both threads and makes Acquire() return nullptr once everything published was drawn
+    void Close();
+private:
+    RenderSnapshot          slots[3];
+    int                     writing, ready, rendering;
+    bool                    closed;
+    std::mutex              mutex;
+    std::condition_variable changed;
+};
+
+#endif
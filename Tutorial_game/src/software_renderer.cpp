@@ -0,0 +1,688 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "software_renderer.h"
+#include "framebuffer_blit.h"
+#include "game.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SOFTWARE_RENDERER_SSE2
+#endif
+
+// Opaque black, what every frame starts from
+constexpr std::uint32_t CLEAR_COLOR = 0xFF000000u;
+
+
+// The four channels of a pixel as floats in [0, 255] (or a factor per
+// channel); in one SSE register where available
+#ifdef SOFTWARE_RENDERER_SSE2
+struct Pixel {
+    __m128 V;
+};
+
+static inline Pixel splat(float value) { return { _mm_set1_ps(value) }; }
+static inline Pixel makePixel(glm::vec4 value) { return { _mm_setr_ps(value.r, value.g, value.b, value.a) }; }
+static inline Pixel operator+(Pixel a, Pixel b) { return { _mm_add_ps(a.V, b.V) }; }
+static inline Pixel operator-(Pixel a, Pixel b) { return { _mm_sub_ps(a.V, b.V) }; }
+static inline Pixel operator*(Pixel a, Pixel b) { return { _mm_mul_ps(a.V, b.V) }; }
+static inline Pixel clampColor(Pixel a) { return { _mm_min_ps(_mm_max_ps(a.V, _mm_setzero_ps()), _mm_set1_ps(255.0f)) }; }
+static inline Pixel alphaOf(Pixel a) { return { _mm_shuffle_ps(a.V, a.V, _MM_SHUFFLE(3, 3, 3, 3)) }; }
+static inline float alphaValue(Pixel a) { return _mm_cvtss_f32(alphaOf(a).V); }
+
+static inline Pixel unpack(std::uint32_t rgba)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i channels = _mm_cvtsi32_si128(static_cast<int>(rgba));
+    channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(channels, zero), zero);
+    return { _mm_cvtepi32_ps(channels) };
+}
+
+static inline std::uint32_t pack(Pixel a)
+{
+    // rounds to nearest (even) and saturates to [0, 255]
+    __m128i channels = _mm_cvtps_epi32(a.V);
+    channels = _mm_packs_epi32(channels, channels);
+    channels = _mm_packus_epi16(channels, channels);
+    return static_cast<std::uint32_t>(_mm_cvtsi128_si32(channels));
+}
+#else
+struct Pixel {
+    float V[4];
+};
+
+static inline Pixel splat(float value) { return { { value, value, value, value } }; }
+static inline Pixel makePixel(glm::vec4 value) { return { { value.r, value.g, value.b, value.a } }; }
+static inline Pixel operator+(Pixel a, Pixel b) { return { { a.V[0] + b.V[0], a.V[1] + b.V[1], a.V[2] + b.V[2], a.V[3] + b.V[3] } }; }
+static inline Pixel operator-(Pixel a, Pixel b) { return { { a.V[0] - b.V[0], a.V[1] - b.V[1], a.V[2] - b.V[2], a.V[3] - b.V[3] } }; }
+static inline Pixel operator*(Pixel a, Pixel b) { return { { a.V[0] * b.V[0], a.V[1] * b.V[1], a.V[2] * b.V[2], a.V[3] * b.V[3] } }; }
+static inline Pixel alphaOf(Pixel a) { return splat(a.V[3]); }
+static inline float alphaValue(Pixel a) { return a.V[3]; }
+
+static inline Pixel clampColor(Pixel a)
+{
+    for (float &channel : a.V)
+        channel = std::min(std::max(channel, 0.0f), 255.0f);
+    return a;
+}
+
+static inline Pixel unpack(std::uint32_t rgba)
+{
+    return { { static_cast<float>(rgba & 0xFF), static_cast<float>((rgba >> 8) & 0xFF),
+               static_cast<float>((rgba >> 16) & 0xFF), static_cast<float>(rgba >> 24) } };
+}
+
+static inline std::uint32_t pack(Pixel a)
+{
+    // same rounding as the SSE path (to nearest even in the default rounding mode)
+    std::uint32_t rgba = 0;
+    for (unsigned int i = 0; i < 4; ++i)
+        rgba |= static_cast<std::uint32_t>(std::min(std::max(std::nearbyint(a.V[i]), 0.0f), 255.0f)) << (i * 8);
+    return rgba;
+}
+#endif
+
+static inline Pixel lerp(Pixel a, Pixel b, float t)
+{
+    return a + (b - a) * splat(t);
+}
+
+// samples an image like GL_LINEAR with GL_CLAMP_TO_EDGE would
+static Pixel sample(const SoftwareImage &image, float u, float v)
+{
+    const float s = u * image.Width - 0.5f, t = v * image.Height - 0.5f;
+    const float s0 = std::floor(s), t0 = std::floor(t);
+    const int maxX = image.Width - 1, maxY = image.Height - 1;
+    const int x0 = std::clamp(static_cast<int>(s0), 0, maxX), x1 = std::clamp(static_cast<int>(s0) + 1, 0, maxX);
+    const int y0 = std::clamp(static_cast<int>(t0), 0, maxY), y1 = std::clamp(static_cast<int>(t0) + 1, 0, maxY);
+    const float fx = s - s0, fy = t - t0;
+    const std::uint32_t *row0 = &image.Pixels[y0 * image.Width], *row1 = &image.Pixels[y1 * image.Width];
+    // sprites drawn at their own size hit the texel centers
+    if (fx == 0.0f && fy == 0.0f)
+        return unpack(row0[x0]);
+    const Pixel top = lerp(unpack(row0[x0]), unpack(row0[x1]), fx);
+    const Pixel bottom = lerp(unpack(row1[x0]), unpack(row1[x1]), fx);
+    return lerp(top, bottom, fy);
+}
+
+#ifdef SOFTWARE_RENDERER_SSE2
+// Four pixels of a span, each channel in a register of its own
+struct Pixels4 {
+    __m128 R, G, B, A;
+};
+
+// unpacks four RGBA8 pixels
+static inline Pixels4 unpack4(__m128i rgba)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    return { _mm_cvtepi32_ps(_mm_and_si128(rgba, mask)), _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgba, 8), mask)),
+             _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgba, 16), mask)), _mm_cvtepi32_ps(_mm_srli_epi32(rgba, 24)) };
+}
+
+// packs four pixels, rounding and saturating like pack()
+static inline __m128i pack4(const Pixels4 &a)
+{
+    const __m128i rg = _mm_packs_epi32(_mm_cvtps_epi32(a.R), _mm_cvtps_epi32(a.G));
+    const __m128i ba = _mm_packs_epi32(_mm_cvtps_epi32(a.B), _mm_cvtps_epi32(a.A));
+    const __m128i planar = _mm_packus_epi16(rg, ba); // r0..r3 g0..g3 b0..b3 a0..a3
+    const __m128i rbga = _mm_unpacklo_epi8(planar, _mm_srli_si128(planar, 8)); // r0 b0 .. r3 b3 g0 a0 .. g3 a3
+    return _mm_unpacklo_epi8(rbga, _mm_srli_si128(rbga, 8));
+}
+
+static inline __m128 lerp4(__m128 a, __m128 b, __m128 t)
+{
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+static inline __m128 clamp4(__m128 value, __m128 low, __m128 high)
+{
+    return _mm_min_ps(_mm_max_ps(value, low), high);
+}
+
+// rounds towards negative infinity (SSE2 only truncates)
+static inline __m128 floor4(__m128 value)
+{
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+}
+
+// rasterizes the pixels [first, last) of a span four at a time, with the same results as the
+// per pixel loop of drawQuad (which picks up the rest); a and b are the quad coordinates at
+// pixel 0. Returns the first pixel not drawn.
+static int drawSpan4(const SoftwareRenderer::Primitive &quad, const SoftwareImage &texture, float a, float b, int first, int last, std::uint32_t *pixel)
+{
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 startA = _mm_set1_ps(a), stepA = _mm_set1_ps(quad.AxisU.x);
+    const __m128 startB = _mm_set1_ps(b), stepB = _mm_set1_ps(quad.AxisV.x);
+    const __m128 offsetU = _mm_set1_ps(quad.TexRect.x), scaleU = _mm_set1_ps(quad.TexRect.z);
+    const __m128 offsetV = _mm_set1_ps(quad.TexRect.y), scaleV = _mm_set1_ps(quad.TexRect.w);
+    const __m128 width = _mm_set1_ps(static_cast<float>(texture.Width)), height = _mm_set1_ps(static_cast<float>(texture.Height));
+    const __m128 maxX = _mm_set1_ps(static_cast<float>(texture.Width - 1)), maxY = _mm_set1_ps(static_cast<float>(texture.Height - 1));
+    const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps(), opaque = _mm_set1_ps(255.0f);
+    const __m128 tintR = _mm_set1_ps(quad.Color.r), tintG = _mm_set1_ps(quad.Color.g);
+    const __m128 tintB = _mm_set1_ps(quad.Color.b), tintA = _mm_set1_ps(quad.Color.a);
+    const __m128 toFactor = _mm_set1_ps(1.0f / 255.0f);
+    const bool additive = quad.Blend == BLEND_ADDITIVE;
+    int i = first;
+    for (; i + 4 <= last; i += 4)
+    {
+        // texel coordinates of the four pixel centers, and their bilinear weights
+        const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane);
+        const __m128 u = _mm_add_ps(offsetU, _mm_mul_ps(_mm_add_ps(startA, _mm_mul_ps(stepA, index)), scaleU));
+        const __m128 v = _mm_add_ps(offsetV, _mm_mul_ps(_mm_add_ps(startB, _mm_mul_ps(stepB, index)), scaleV));
+        const __m128 s = _mm_sub_ps(_mm_mul_ps(u, width), half), t = _mm_sub_ps(_mm_mul_ps(v, height), half);
+        const __m128 s0 = floor4(s), t0 = floor4(t);
+        const __m128 fx = _mm_sub_ps(s, s0), fy = _mm_sub_ps(t, t0);
+        alignas(16) std::int32_t x0[4], x1[4], y0[4], y1[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_cvttps_epi32(clamp4(s0, zero, maxX)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(x1), _mm_cvttps_epi32(clamp4(_mm_add_ps(s0, one), zero, maxX)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_cvttps_epi32(clamp4(t0, zero, maxY)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(y1), _mm_cvttps_epi32(clamp4(_mm_add_ps(t0, one), zero, maxY)));
+        // fetch the 2x2 texels of every pixel (SSE2 has no gather)
+        alignas(16) std::uint32_t texel00[4], texel01[4], texel10[4], texel11[4];
+        for (unsigned int k = 0; k < 4; ++k)
+        {
+            const std::uint32_t *row0 = &texture.Pixels[y0[k] * texture.Width], *row1 = &texture.Pixels[y1[k] * texture.Width];
+            texel00[k] = row0[x0[k]];
+            texel01[k] = row0[x1[k]];
+            texel10[k] = row1[x0[k]];
+            texel11[k] = row1[x1[k]];
+        }
+        const Pixels4 p00 = unpack4(_mm_load_si128(reinterpret_cast<const __m128i*>(texel00)));
+        const Pixels4 p01 = unpack4(_mm_load_si128(reinterpret_cast<const __m128i*>(texel01)));
+        const Pixels4 p10 = unpack4(_mm_load_si128(reinterpret_cast<const __m128i*>(texel10)));
+        const Pixels4 p11 = unpack4(_mm_load_si128(reinterpret_cast<const __m128i*>(texel11)));
+        // like GL, the fragment color is clamped before blending
+        Pixels4 source;
+        source.R = clamp4(_mm_mul_ps(lerp4(lerp4(p00.R, p01.R, fx), lerp4(p10.R, p11.R, fx), fy), tintR), zero, opaque);
+        source.G = clamp4(_mm_mul_ps(lerp4(lerp4(p00.G, p01.G, fx), lerp4(p10.G, p11.G, fx), fy), tintG), zero, opaque);
+        source.B = clamp4(_mm_mul_ps(lerp4(lerp4(p00.B, p01.B, fx), lerp4(p10.B, p11.B, fx), fy), tintB), zero, opaque);
+        source.A = clamp4(_mm_mul_ps(lerp4(lerp4(p00.A, p01.A, fx), lerp4(p10.A, p11.A, fx), fy), tintA), zero, opaque);
+        // transparent pixels are left alone
+        const __m128 visible = _mm_cmpgt_ps(source.A, zero);
+        if (_mm_movemask_ps(visible) == 0)
+            continue;
+        // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA or GL_SRC_ALPHA, GL_ONE
+        __m128i *target = reinterpret_cast<__m128i*>(pixel + i);
+        const __m128i previous = _mm_loadu_si128(target);
+        const Pixels4 destination = unpack4(previous);
+        const __m128 factor = _mm_mul_ps(source.A, toFactor);
+        Pixels4 blended;
+        __m128i result;
+        if (additive)
+        {
+            blended.R = _mm_add_ps(_mm_mul_ps(source.R, factor), destination.R);
+            blended.G = _mm_add_ps(_mm_mul_ps(source.G, factor), destination.G);
+            blended.B = _mm_add_ps(_mm_mul_ps(source.B, factor), destination.B);
+            blended.A = _mm_add_ps(_mm_mul_ps(source.A, factor), destination.A);
+            result = pack4(blended);
+        }
+        else
+        {
+            blended.R = lerp4(destination.R, source.R, factor);
+            blended.G = lerp4(destination.G, source.G, factor);
+            blended.B = lerp4(destination.B, source.B, factor);
+            blended.A = lerp4(destination.A, source.A, factor);
+            // opaque pixels replace the destination
+            const __m128i replace = _mm_castps_si128(_mm_cmpge_ps(source.A, opaque));
+            result = _mm_or_si128(_mm_and_si128(replace, pack4(source)), _mm_andnot_si128(replace, pack4(blended)));
+        }
+        const __m128i write = _mm_castps_si128(visible);
+        _mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(write, result), _mm_andnot_si128(write, previous)));
+    }
+    return i;
+}
+#endif
+
+// narrows the span [from, to) of pixel offsets to those where value + step * offset is in [0, 1)
+static void clipSpan(float value, float step, float &from, float &to)
+{
+    if (step == 0.0f)
+    {
+        if (value < 0.0f || value >= 1.0f)
+            to = from;
+        return;
+    }
+    float enter = -value / step, leave = (1.0f - value) / step;
+    if (step < 0.0f)
+        std::swap(enter, leave);
+    from = std::max(from, enter);
+    to = std::min(to, leave);
+}
+
+// rasterizes the part of a quad inside the given pixel rectangle of the target
+static void drawQuad(const SoftwareRenderer::Primitive &quad, SoftwareImage &target, const SoftwareImage &layer, int tileX0, int tileY0, int tileX1, int tileY1)
+{
+    const int x0 = std::max(quad.MinX, tileX0), x1 = std::min(quad.MaxX, tileX1);
+    const int y0 = std::max(quad.MinY, tileY0), y1 = std::min(quad.MaxY, tileY1);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    if (!quad.Texture)
+    {   // the static layer is opaque and covers the view 1:1
+        for (int y = y0; y < y1; ++y)
+            std::memcpy(&target.Pixels[y * target.Width + x0], &layer.Pixels[y * layer.Width + x0], (x1 - x0) * sizeof(std::uint32_t));
+        return;
+    }
+    const SoftwareImage &texture = *quad.Texture;
+    const Pixel tint = makePixel(quad.Color);
+    const Pixel toFactor = splat(1.0f / 255.0f);
+    const bool additive = quad.Blend == BLEND_ADDITIVE;
+    for (int y = y0; y < y1; ++y)
+    {
+        // quad coordinates at the first pixel center of the row; they change by AxisU.x/AxisV.x per pixel
+        const glm::vec2 offset(x0 + 0.5f - quad.Center.x, y + 0.5f - quad.Center.y);
+        const float a = glm::dot(offset, quad.AxisU) + 0.5f, b = glm::dot(offset, quad.AxisV) + 0.5f;
+        const float stepA = quad.AxisU.x, stepB = quad.AxisV.x;
+        int first = 0, last = x1 - x0;
+        if (quad.Rotated)
+        {   // the span of pixel centers inside all four edges
+            float from = 0.0f, to = static_cast<float>(last);
+            clipSpan(a, stepA, from, to);
+            clipSpan(b, stepB, from, to);
+            if (from >= to)
+                continue;
+            first = std::max(first, static_cast<int>(std::ceil(from)));
+            last = std::min(last, static_cast<int>(std::ceil(to)));
+        }
+        std::uint32_t *pixel = &target.Pixels[y * target.Width + x0];
+#ifdef SOFTWARE_RENDERER_SSE2
+        first = drawSpan4(quad, texture, a, b, first, last, pixel);
+#endif
+        for (int i = first; i < last; ++i)
+        {
+            const float u = quad.TexRect.x + (a + stepA * i) * quad.TexRect.z;
+            const float v = quad.TexRect.y + (b + stepB * i) * quad.TexRect.w;
+            // like GL, the fragment color is clamped before blending
+            const Pixel source = clampColor(sample(texture, u, v) * tint);
+            const float alpha = alphaValue(source);
+            if (alpha <= 0.0f)
+                continue;
+            if (!additive && alpha >= 255.0f)
+            {
+                pixel[i] = pack(source);
+                continue;
+            }
+            // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA or GL_SRC_ALPHA, GL_ONE
+            const Pixel factor = alphaOf(source) * toFactor;
+            const Pixel destination = unpack(pixel[i]);
+            if (additive)
+                pixel[i] = pack(source * factor + destination);
+            else
+                pixel[i] = pack(destination + (source - destination) * factor);
+        }
+    }
+}
+
+// wraps a coordinate into [0, size) like GL_REPEAT
+static inline int wrap(int value, int size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+
+SoftwareRenderer::SoftwareRenderer()
+    : Presenter(nullptr), Threads(0), textures(), scene(), post(), layer(), finished(&scene), buffers(), particleBackend(PARTICLES_CPU),
+      particles(), particleRegion(), primitives(), target(nullptr), tilesX(0), tilesY(0), bins(), effects(0), time(0.0f),
+      pool(),
+      frames(0), primitiveCount(0), rasterTime(0.0), lastFrameTime(0.0f), layerBakes(0), queueStats()
+{
+
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+
+}
+
+void SoftwareRenderer::Init(unsigned int width, unsigned int height, AntiAliasing /*aa*/, ParticleBackend particles, unsigned int particleCount)
+{
+    // load every image as RGBA8; each is a texture of its own, so all regions cover their whole texture
+    std::vector<SpriteAsset> assets(std::begin(SPRITE_ASSETS), std::end(SPRITE_ASSETS));
+    assets.push_back(BACKGROUND_ASSET);
+    for (const SpriteAsset &asset : assets)
+    {
+        int imageWidth, imageHeight, channels;
+        unsigned char *data = stbi_load(asset.File, &imageWidth, &imageHeight, &channels, 4);
+        if (!data)
+        {
+            std::cout << "ERROR::SOFTWARERENDERER: Failed to load image: " << asset.File << std::endl;
+            continue;
+        }
+        SoftwareImage image;
+        image.Width = imageWidth;
+        image.Height = imageHeight;
+        image.Pixels.resize(imageWidth * imageHeight);
+        std::memcpy(image.Pixels.data(), data, image.Pixels.size() * sizeof(std::uint32_t));
+        stbi_image_free(data);
+        if (!asset.Alpha)
+            for (std::uint32_t &pixel : image.Pixels)
+                pixel |= 0xFF000000u;
+        this->textures.push_back(std::move(image));
+        SpriteRegistry::Regions[asset.Name] = TextureRegion(this->textures.size(), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    }
+    // with the GPU backend the particle state lives in the renderer
+    this->particleBackend = particles;
+    this->particleRegion = SpriteRegistry::Get("particle");
+    if (particles == PARTICLES_GPU)
+        this->particles.assign(particleCount, Particle());
+
+    // render targets and tiles
+    for (SoftwareImage *image : { &this->scene, &this->post, &this->layer })
+    {
+        image->Width = width;
+        image->Height = height;
+        image->Pixels.assign(width * height, CLEAR_COLOR);
+    }
+    this->tilesX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    this->tilesY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+    // one binning job per thread; the calling thread is one of them
+    this->pool.Start(this->Threads);
+    this->bins.assign(this->pool.ThreadCount(), std::vector<std::vector<unsigned int>>(this->tilesX * this->tilesY));
+}
+
+void SoftwareRenderer::Draw(RenderSnapshot &frame)
+{
+    if (!frame.Active)
+        return;
+    const auto start = std::chrono::steady_clock::now();
+    RenderQueue &queue = frame.Queue;
+    // bring the static layer and resident buffers up to date first, in recording order
+    for (const LayerBake &bake : queue.Bakes())
+    {
+        this->primitives.clear();
+        for (const StaticSprite &sprite : bake.Sprites)
+            this->addQuad(this->findTexture(sprite.Texture), sprite.Instance.Rect, sprite.Instance.ColorRotation.w,
+                sprite.Instance.TexRect, glm::vec4(glm::vec3(sprite.Instance.ColorRotation), 1.0f), BLEND_ALPHA);
+        this->rasterize(this->layer);
+        this->layerBakes++;
+    }
+    for (const BufferUpdate &update : queue.Updates())
+    {
+        std::vector<SpriteInstance> &instances = this->buffers[update.Buffer];
+        if (update.Index < 0)
+        {
+            instances = update.Instances;
+            update.Buffer->Count = instances.size();
+        }
+        else if (static_cast<unsigned int>(update.Index) < instances.size())
+            instances[update.Index] = update.Instances[0];
+    }
+
+    // turn the commands into quads in draw order
+    queue.Sort();
+    this->primitives.clear();
+    for (unsigned int i = 0; i < queue.Size(); ++i)
+    {
+        const RenderCommand &command = queue.Command(i);
+        switch (command.Type)
+        {
+        case COMMAND_SPRITE:
+            this->addQuad(this->findTexture(command.Texture), command.Instance.Rect, command.Instance.ColorRotation.w,
+                command.Instance.TexRect, glm::vec4(glm::vec3(command.Instance.ColorRotation), 1.0f), BLEND_ALPHA);
+            break;
+        case COMMAND_SPRITE_BUFFER:
+        {
+            auto buffer = this->buffers.find(command.Buffer);
+            if (buffer == this->buffers.end())
+                break;
+            for (const SpriteInstance &instance : buffer->second)
+                this->addQuad(this->findTexture(command.Texture), instance.Rect, instance.ColorRotation.w,
+                    instance.TexRect, glm::vec4(glm::vec3(instance.ColorRotation), 1.0f), BLEND_ALPHA);
+            break;
+        }
+        case COMMAND_STATIC_LAYER:
+        {
+            Primitive copy = Primitive();
+            copy.MaxX = this->scene.Width;
+            copy.MaxY = this->scene.Height;
+            this->primitives.push_back(copy);
+            break;
+        }
+        case COMMAND_PARTICLES:
+            this->addParticles(*command.ParticleData);
+            break;
+        }
+    }
+    this->rasterize(this->scene);
+    this->primitiveCount += this->primitives.size();
+
+    // fullscreen effects go into a second image, as every pixel may read any other
+    this->effects = frame.Effects;
+    this->time = frame.Time;
+    this->finished = &this->scene;
+    if (this->effects != 0)
+    {
+        this->pool.ParallelFor(this->tilesX * this->tilesY, [this](unsigned int tile) { this->effectsJob(tile); });
+        this->finished = &this->post;
+    }
+
+    this->queueStats = queue.Stats;
+    queue.Clear();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    this->rasterTime += seconds;
+    this->lastFrameTime = static_cast<float>(seconds);
+    this->frames++;
+    if (this->Presenter)
+        this->Presenter->Present(*this->finished);
+}
+
+void SoftwareRenderer::PrintStats()
+{
+    const RenderQueueStats &stats = this->queueStats;
+    std::cout << "RENDERQUEUE: last frame: " << stats.Commands << " commands, " << stats.Culled << " culled" << std::endl;
+    std::cout << "SOFTWARERENDERER: " << this->frames << " frames on " << this->pool.ThreadCount() << " threads, "
+        << (this->frames ? this->rasterTime * 1000.0 / this->frames : 0.0) << " ms and "
+        << (this->frames ? static_cast<double>(this->primitiveCount) / this->frames : 0.0) << " quads per frame; static layer baked "
+        << this->layerBakes << " times" << std::endl;
+}
+
+float SoftwareRenderer::GpuFrameTime() const
+{
+    return this->lastFrameTime;
+}
+
+const SoftwareImage &SoftwareRenderer::Image() const
+{
+    return *this->finished;
+}
+
+void SoftwareRenderer::addQuad(const SoftwareImage *texture, glm::vec4 rect, float rotation, glm::vec4 texRect, glm::vec4 color, BlendMode blend)
+{
+    const glm::vec2 position(rect.x, rect.y), size(rect.z, rect.w);
+    if (!texture || size.x <= 0.0f || size.y <= 0.0f)
+        return;
+    Primitive quad;
+    quad.Texture = texture;
+    quad.Blend = blend;
+    quad.Rotated = rotation != 0.0f;
+    quad.Center = position + 0.5f * size;
+    quad.TexRect = texRect;
+    quad.Color = color;
+    // the inverse of the sprite shader's rotation, scaled to the quad's size
+    const float angle = glm::radians(rotation);
+    const float c = std::cos(angle), s = std::sin(angle);
+    quad.AxisU = glm::vec2(c, s) / size.x;
+    quad.AxisV = glm::vec2(-s, c) / size.y;
+    // pixels with their center inside the quad's bounds (rotated quads clip each row further)
+    const glm::vec2 extent = 0.5f * glm::vec2(std::abs(c) * size.x + std::abs(s) * size.y, std::abs(s) * size.x + std::abs(c) * size.y);
+    const glm::vec2 lower = quad.Center - extent - 0.5f, upper = quad.Center + extent - 0.5f;
+    quad.MinX = std::max(0, static_cast<int>(std::ceil(lower.x)));
+    quad.MinY = std::max(0, static_cast<int>(std::ceil(lower.y)));
+    quad.MaxX = std::min(static_cast<int>(this->scene.Width), static_cast<int>(std::ceil(upper.x)));
+    quad.MaxY = std::min(static_cast<int>(this->scene.Height), static_cast<int>(std::ceil(upper.y)));
+    if (quad.MinX < quad.MaxX && quad.MinY < quad.MaxY)
+        this->primitives.push_back(quad);
+}
+
+void SoftwareRenderer::addParticles(const ParticleFrame &frame)
+{
+    // particles are 10x10 quads at their offset (see particle.vert), blended additively
+    const SoftwareImage *texture = this->findTexture(this->particleRegion.ID);
+    if (this->particleBackend == PARTICLES_CPU)
+    {
+        if (!frame.Visible)
+            return;
+        for (const ParticleInstance &particle : frame.Instances)
+            this->addQuad(texture, glm::vec4(particle.Offset, 10.0f, 10.0f), 0.0f, this->particleRegion.UV, particle.Color, BLEND_ADDITIVE);
+        return;
+    }
+    // the same steps the transform feedback pass takes (see particle_update.vert)
+    for (const auto &spawn : frame.Spawns)
+        if (spawn.first < this->particles.size())
+            this->particles[spawn.first] = spawn.second;
+    const float dt = frame.Time;
+    if (dt > 0.0f)
+    {
+        for (Particle &particle : this->particles)
+        {
+            particle.Life -= dt;
+            if (particle.Life > 0.0f)
+            {
+                particle.Position += particle.Velocity * dt;
+                particle.Color.a -= dt * 2.5f;
+            }
+            else
+                particle.Color.a = 0.0f;
+        }
+    }
+    if (!frame.Visible)
+        return;
+    for (const Particle &particle : this->particles)
+        if (particle.Color.a > 0.0f)
+            this->addQuad(texture, glm::vec4(particle.Position, 10.0f, 10.0f), 0.0f, this->particleRegion.UV, particle.Color, BLEND_ADDITIVE);
+}
+
+void SoftwareRenderer::rasterize(SoftwareImage &target)
+{
+    this->target = &target;
+    this->pool.ParallelFor(this->pool.ThreadCount(), [this](unsigned int job) { this->binJob(job); });
+    this->pool.ParallelFor(this->tilesX * this->tilesY, [this](unsigned int tile) { this->tileJob(tile); });
+}
+
+void SoftwareRenderer::binJob(unsigned int index)
+{
+    // every job bins a contiguous share of the primitives, so walking the jobs in order keeps the draw order
+    std::vector<std::vector<unsigned int>> &tiles = this->bins[index];
+    for (std::vector<unsigned int> &tile : tiles)
+        tile.clear();
+    const unsigned int count = this->primitives.size();
+    const unsigned int jobs = this->pool.ThreadCount();
+    const unsigned int first = count * index / jobs, last = count * (index + 1) / jobs;
+    for (unsigned int i = first; i < last; ++i)
+    {
+        const Primitive &quad = this->primitives[i];
+        for (int y = quad.MinY / SOFTWARE_TILE_SIZE; y <= (quad.MaxY - 1) / static_cast<int>(SOFTWARE_TILE_SIZE); ++y)
+            for (int x = quad.MinX / SOFTWARE_TILE_SIZE; x <= (quad.MaxX - 1) / static_cast<int>(SOFTWARE_TILE_SIZE); ++x)
+                tiles[y * this->tilesX + x].push_back(i);
+    }
+}
+
+void SoftwareRenderer::tileJob(unsigned int index)
+{
+    SoftwareImage &target = *this->target;
+    const int x0 = (index % this->tilesX) * SOFTWARE_TILE_SIZE, y0 = (index / this->tilesX) * SOFTWARE_TILE_SIZE;
+    const int x1 = std::min(x0 + static_cast<int>(SOFTWARE_TILE_SIZE), static_cast<int>(target.Width));
+    const int y1 = std::min(y0 + static_cast<int>(SOFTWARE_TILE_SIZE), static_cast<int>(target.Height));
+    for (int y = y0; y < y1; ++y)
+        std::fill(&target.Pixels[y * target.Width + x0], &target.Pixels[y * target.Width + x1], CLEAR_COLOR);
+    for (const std::vector<std::vector<unsigned int>> &tiles : this->bins)
+        for (unsigned int primitive : tiles[index])
+            drawQuad(this->primitives[primitive], target, this->layer, x0, y0, x1, y1);
+}
+
+void SoftwareRenderer::effectsJob(unsigned int index)
+{
+    // the effects of effects.vert/effects.frag, with all offsets rounded to whole pixels; the
+    // scene's rows go top down where GL's texture coordinates go bottom up
+    const SoftwareImage &source = this->scene;
+    const int width = source.Width, height = source.Height;
+    const bool chaos = this->effects & EFFECT_CHAOS, confuse = this->effects & EFFECT_CONFUSE, shake = this->effects & EFFECT_SHAKE;
+    int shakeX = 0, shakeY = 0, chaosX = 0, chaosY = 0;
+    if (shake)
+    {   // the whole image moves, uncovering black
+        shakeX = static_cast<int>(std::lround(std::cos(this->time * 10.0f) * 0.01f * 0.5f * width));
+        shakeY = static_cast<int>(std::lround(std::cos(this->time * 15.0f) * 0.01f * 0.5f * height));
+    }
+    if (chaos)
+    {
+        chaosX = static_cast<int>(std::lround(std::sin(this->time) * 0.3f * width));
+        chaosY = static_cast<int>(std::lround(std::cos(this->time) * 0.3f * height));
+    }
+    // the kernels' sample offsets of 1/300 of the scene
+    const int offsetX = std::max(1, static_cast<int>(std::lround(width / 300.0f)));
+    const int offsetY = std::max(1, static_cast<int>(std::lround(height / 300.0f)));
+    static const float edgeKernel[9] = { -1.0f, -1.0f, -1.0f, -1.0f, 8.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+    static const float blurKernel[9] = {
+        1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
+        2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
+        1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f
+    };
+    const float *kernel = chaos ? edgeKernel : (shake && !confuse ? blurKernel : nullptr);
+
+    const int x0 = (index % this->tilesX) * SOFTWARE_TILE_SIZE, y0 = (index / this->tilesX) * SOFTWARE_TILE_SIZE;
+    const int x1 = std::min(x0 + static_cast<int>(SOFTWARE_TILE_SIZE), width);
+    const int y1 = std::min(y0 + static_cast<int>(SOFTWARE_TILE_SIZE), height);
+    for (int y = y0; y < y1; ++y)
+    {
+        std::uint32_t *pixel = &this->post.Pixels[y * width];
+        for (int x = x0; x < x1; ++x)
+        {
+            int sceneX = x - shakeX, sceneY = y + shakeY;
+            if (sceneX < 0 || sceneX >= width || sceneY < 0 || sceneY >= height)
+            {
+                pixel[x] = CLEAR_COLOR;
+                continue;
+            }
+            if (chaos)
+            {
+                sceneX = wrap(sceneX + chaosX, width);
+                sceneY = wrap(sceneY - chaosY, height);
+            }
+            else if (confuse)
+            {
+                sceneX = width - 1 - sceneX;
+                sceneY = height - 1 - sceneY;
+            }
+            Pixel color;
+            if (kernel)
+            {
+                color = splat(0.0f);
+                for (int i = 0; i < 9; ++i)
+                {
+                    const int sampleX = wrap(sceneX + (i % 3 - 1) * offsetX, width);
+                    const int sampleY = wrap(sceneY + (i / 3 - 1) * offsetY, height);
+                    color = color + unpack(source.Pixels[sampleY * width + sampleX]) * splat(kernel[i]);
+                }
+            }
+            else
+            {
+                color = unpack(source.Pixels[sceneY * width + sceneX]);
+                if (confuse)
+                    color = splat(255.0f) - color;
+            }
+            pixel[x] = pack(color) | CLEAR_COLOR;
+        }
+    }
+}
+
+const SoftwareImage *SoftwareRenderer::findTexture(unsigned int id) const
+{
+    if (id == 0 || id > this->textures.size())
+        return nullptr;
+    return &this->textures[id - 1];
+}
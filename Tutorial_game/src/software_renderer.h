@@ -0,0 +1,121 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game_renderer.h"
+#include "render_queue.h"
+#include "worker_pool.h"
+
+class FramebufferBlit;
+
+// Edge length in pixels of the square tiles the software renderer bins into
+constexpr unsigned int SOFTWARE_TILE_SIZE = 64;
+
+// An image in main memory: RGBA8 pixels (red in the lowest byte), top row first
+struct SoftwareImage {
+    unsigned int               Width = 0, Height = 0;
+    std::vector<std::uint32_t> Pixels;
+};
+
+
+// SoftwareRenderer draws the game on the CPU, for machines without a
+// GPU and as a deterministic, GPU independent reference. It follows the
+// GL pipeline: textured and tinted sprite quads (bilinear filtered,
+// alpha or additive blended), the particles of both backends and the
+// chaos/confuse/shake effects as a fullscreen pass.
+// Every frame is turned into screen space quads which are binned into
+// tiles (on all worker threads, each binning its share of the quads);
+// the tiles are then rasterized in parallel span by span, a pixel's
+// channels being processed in one SSE register (scalar elsewhere).
+// Tiles never share pixels and keep the recorded draw order, so the
+// image doesn't depend on the number of threads. Anti-aliasing and the
+// render scale don't apply: every pixel is sampled once at full size.
+// Finished frames are handed to the Presenter, if any.
+class SoftwareRenderer : public GameRenderer
+{
+public:
+    // shows the finished frames (e.g. in a window); without one they are only kept in Image()
+    FramebufferBlit *Presenter;
+    // threads to rasterize on, the drawing one included (takes effect in Init; 0: one per hardware thread)
+    unsigned int     Threads;
+    // constructor/destructor
+    SoftwareRenderer();
+    ~SoftwareRenderer();
+    // loads all textures into main memory and starts the worker threads
+    void Init(unsigned int width, unsigned int height, AntiAliasing aa, ParticleBackend particles, unsigned int particleCount) override;
+    void Draw(RenderSnapshot &frame) override;
+    void PrintStats() override;
+    // time the last frame took to rasterize in seconds
+    float GpuFrameTime() const override;
+    // the last finished frame
+    const SoftwareImage &Image() const;
+
+    // A quad in screen space as it is binned and rasterized
+    struct Primitive {
+        const SoftwareImage *Texture; // nullptr: a 1:1 copy of the static layer
+        BlendMode            Blend;
+        bool                 Rotated;                // whether each row has to be clipped to the quad's edges
+        int                  MinX, MinY, MaxX, MaxY; // covered pixels, clipped to the target (max exclusive)
+        glm::vec2            Center;
+        glm::vec2            AxisU, AxisV;           // map offsets from the center to the quad's [-0.5, 0.5] coordinates
+        glm::vec4            TexRect;                // <vec2 uv offset, vec2 uv scale>
+        glm::vec4            Color;
+    };
+private:
+    // textures by ID (ID - 1 is the index)
+    std::vector<SoftwareImage> textures;
+    // the scene, the image after the effects pass and the static layer
+    SoftwareImage scene, post, layer;
+    const SoftwareImage *finished;
+    // CPU copies of the resident sprite buffers
+    std::unordered_map<const SpriteBuffer*, std::vector<SpriteInstance>> buffers;
+    // state of the particles of the GPU backend (simulated here instead)
+    ParticleBackend particleBackend;
+    std::vector<Particle> particles;
+    TextureRegion particleRegion;
+    // the quads of the pass in progress, the image they go to and their bins (per binning job and tile)
+    std::vector<Primitive> primitives;
+    SoftwareImage *target;
+    unsigned int tilesX, tilesY;
+    std::vector<std::vector<std::vector<unsigned int>>> bins;
+    // fullscreen pass settings of the current frame
+    unsigned int effects;
+    float time;
+    // the threads rasterizing; the drawing one works along
+    WorkerPool pool;
+    // statistics
+    unsigned int       frames;
+    unsigned long long primitiveCount;
+    double             rasterTime;
+    std::atomic<float> lastFrameTime; // written by the drawing thread, read by the game thread
+    unsigned int       layerBakes;
+    RenderQueueStats   queueStats;
+    // adds a textured quad (rect: <vec2 position, vec2 size>, rotated in degrees around its center)
+    void addQuad(const SoftwareImage *texture, glm::vec4 rect, float rotation, glm::vec4 texRect, glm::vec4 color, BlendMode blend);
+    // adds the particles of a frame, advancing the GPU backend's state first
+    void addParticles(const ParticleFrame &frame);
+    // bins and rasterizes the current primitives into the target
+    void rasterize(SoftwareImage &target);
+    // jobs run on all threads
+    void binJob(unsigned int index);
+    void tileJob(unsigned int index);
+    void effectsJob(unsigned int index);
+    // a texture by ID (nullptr if unknown)
+    const SoftwareImage *findTexture(unsigned int id) const;
+};
+
+#endif
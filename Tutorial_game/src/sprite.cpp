@@ -0,0 +1,28 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "sprite.h"
+
+
+// Instantiate static variables
+std::unordered_map<std::string, TextureRegion> SpriteRegistry::Regions;
+
+
+SpriteInstance SpriteInstance::Make(const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    // the model transform is built in the vertex shader from position, size and rotation
+    return { glm::vec4(position, size), glm::vec4(color, rotate), texture.UV };
+}
+
+TextureRegion SpriteRegistry::Get(const std::string &name)
+{
+    auto region = Regions.find(name);
+    if (region != Regions.end())
+        return region->second;
+    return TextureRegion();
+}
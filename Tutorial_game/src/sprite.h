@@ -0,0 +1,73 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+
+// TextureRegion references a sub-rectangle of a texture, e.g. a single
+// sprite packed into an atlas page. A plain Texture2D converts to a
+// region covering the whole texture.
+struct TextureRegion {
+    // ID of the texture (atlas page) the region lives in
+    unsigned int ID;
+    // UV range of the region within the texture
+    glm::vec4    UV; // <vec2 offset, vec2 scale>
+    // constructor(s)
+    TextureRegion() : ID(0), UV(0.0f, 0.0f, 1.0f, 1.0f) { }
+    TextureRegion(unsigned int id, glm::vec4 uv) : ID(id), UV(uv) { }
+};
+
+// Per-instance data of a single sprite as uploaded to the GPU
+struct SpriteInstance {
+    glm::vec4 Rect;          // <vec2 position, vec2 size>
+    glm::vec4 ColorRotation; // <vec3 color, float rotation in degrees>
+    glm::vec4 TexRect;       // <vec2 uv offset, vec2 uv scale>
+
+    // builds the instance data of a sprite
+    static SpriteInstance Make(const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+};
+
+// A set of sprite instances kept resident on the GPU. It is uploaded
+// once, patched in place and drawn with a single instanced call.
+// The simulation only owns the handle; the renderer fills it in.
+struct SpriteBuffer {
+    unsigned int VAO = 0, VBO = 0;
+    unsigned int Count = 0;
+};
+
+// A sprite baked into a static layer
+struct StaticSprite {
+    unsigned int   Texture;
+    SpriteInstance Instance;
+};
+
+
+// A static registry of the texture regions the game draws with, by
+// name. Sprite data is plain old data, so the simulation only ever
+// sees regions and never the textures behind them: the renderer fills
+// the registry while loading its textures (see ResourceManager::BuildAtlas)
+// and without one (headless) every lookup yields an empty region.
+class SpriteRegistry
+{
+public:
+    // region storage
+    static std::unordered_map<std::string, TextureRegion> Regions;
+    // retrieves a region; unknown names yield an empty region (texture 0)
+    static TextureRegion Get(const std::string &name);
+private:
+    // private constructor, all members are static
+    SpriteRegistry() { }
+};
+
+#endif
@@ -7,54 +7,126 @@
 ** option) any later version.
 ******************************************************************/
 #include "sprite_renderer.h"
+#include "gl_state.h"
+
+#include <cstddef>
 
 
 SpriteRenderer::SpriteRenderer(const Shader &shader)
+    : DrawCalls(0), batchTexture(0), batching(false)
 {
     this->shader = shader;
+    this->instances.reserve(MAX_BATCH_SPRITES);
     this->initRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer()
 {
-    glDeleteVertexArrays(1, &this->quadVAO);
+    GLState::DeleteVertexArray(this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
+    glDeleteBuffers(1, &this->instanceVBO);
 }
 
-void SpriteRenderer::DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+void SpriteRenderer::DrawSprite(const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
 {
-    // prepare transformations
-    this->shader.Use();
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));  // first translate (transformations are: scale happens first, then rotation, and then final translation happens; reversed order)
+    this->Submit(texture, position, size, rotate, color);
+}
+
+void SpriteRenderer::Begin()
+{
+    this->batching = true;
+}
+
+void SpriteRenderer::Submit(const TextureRegion &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    this->SubmitInstance(texture.ID, SpriteInstance::Make(texture, position, size, rotate, color));
+}
+
+void SpriteRenderer::SubmitInstance(unsigned int texture, const SpriteInstance &instance)
+{
+    // a texture switch (or a full buffer) breaks the batch
+    if (!this->instances.empty() && (texture != this->batchTexture || this->instances.size() == MAX_BATCH_SPRITES))
+        this->drawBatch();
+    this->batchTexture = texture;
+    this->instances.push_back(instance);
+
+    if (!this->batching)
+        this->drawBatch();
+}
+
+void SpriteRenderer::Flush()
+{
+    this->drawBatch();
+    this->batching = false;
+}
 
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f)); // move origin of rotation to center of quad
-    model = glm::rotate(model, glm::radians(rotate), glm::vec3(0.0f, 0.0f, 1.0f)); // then rotate
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f)); // move origin back
+void SpriteRenderer::UploadBuffer(SpriteBuffer &buffer, const std::vector<SpriteInstance> &instances)
+{
+    if (buffer.VAO == 0)
+    {
+        glGenVertexArrays(1, &buffer.VAO);
+        glGenBuffers(1, &buffer.VBO);
+        this->initInstanceAttributes(buffer.VAO, buffer.VBO);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SpriteInstance), instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    buffer.Count = instances.size();
+}
 
-    model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
+void SpriteRenderer::UpdateBuffer(SpriteBuffer &buffer, unsigned int index, const SpriteInstance &instance)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(SpriteInstance), sizeof(SpriteInstance), &instance);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    this->shader.SetMatrix4("model", model);
+void SpriteRenderer::DrawBuffer(const SpriteBuffer &buffer, unsigned int texture)
+{
+    // keep the painter's order with everything queued so far
+    this->drawBatch();
+    if (buffer.Count == 0)
+        return;
+    this->prepareDraw(texture);
+    GLState::BindVertexArray(buffer.VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, buffer.Count);
+    this->DrawCalls++;
+}
 
-    // render textured quad
-    this->shader.SetVector3f("spriteColor", color);
+void SpriteRenderer::drawBatch()
+{
+    if (this->instances.empty())
+        return;
+    // upload instance data (orphan the previous storage so we don't stall on the last draw)
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, MAX_BATCH_SPRITES * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, this->instances.size() * sizeof(SpriteInstance), this->instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // render textured quads
+    this->prepareDraw(this->batchTexture);
+    GLState::BindVertexArray(this->quadVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, this->instances.size());
 
-    glActiveTexture(GL_TEXTURE0);
-    texture.Bind();
+    this->DrawCalls++;
+    this->instances.clear();
+}
 
-    glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+void SpriteRenderer::prepareDraw(unsigned int texture)
+{
+    // redundant state changes are filtered by GLState
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    this->shader.Use();
+    GLState::BindTexture(texture, 0);
 }
 
 void SpriteRenderer::initRenderData()
 {
     // configure VAO/VBO
-    unsigned int VBO;
-    const float vertices[] = { 
+    const float vertices[] = {
         // pos      // tex
         0.0f, 1.0f, 0.0f, 1.0f,
         1.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f, 0.0f, 
+        0.0f, 0.0f, 0.0f, 0.0f,
 
         0.0f, 1.0f, 0.0f, 1.0f,
         1.0f, 1.0f, 1.0f, 1.0f,
@@ -62,14 +134,33 @@ void SpriteRenderer::initRenderData()
     };
 
     glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &this->quadVBO);
+    glGenBuffers(1, &this->instanceVBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, MAX_BATCH_SPRITES * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+
+    this->initInstanceAttributes(this->quadVAO, this->instanceVBO);
+}
 
-    glBindVertexArray(this->quadVAO);
+void SpriteRenderer::initInstanceAttributes(unsigned int VAO, unsigned int instanceVBO)
+{
+    GLState::BindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-instance attributes advance once per sprite
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Rect));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, ColorRotation));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, TexRect));
+    glVertexAttribDivisor(3, 1);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
@@ -9,14 +9,24 @@
 #ifndef SPRITE_RENDERER_H
 #define SPRITE_RENDERER_H
 
+#include <vector>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "texture.h"
+#include "sprite.h"
 #include "shader.h"
 
 
+// Maximum number of sprites drawn by a single instanced draw call
+constexpr unsigned int MAX_BATCH_SPRITES = 1024;
+
+// SpriteRenderer draws textured quads. Sprites submitted between
+// Begin() and Flush() are collected in a CPU-side instance buffer
+// and drawn with as few instanced draw calls as possible; a new
+// draw call is only started when the texture changes.
 class SpriteRenderer
 {
 public:
@@ -24,14 +34,41 @@ public:
     SpriteRenderer(const Shader &shader);
     // Destructor
     ~SpriteRenderer();
-    // Renders a defined quad textured with given sprite
-    void DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // Renders a defined quad textured with given sprite (queued if a batch is open)
+    void DrawSprite(const TextureRegion &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // Opens a batch; sprites are queued until Flush() is called
+    void Begin();
+    // Queues a sprite; outside of Begin()/Flush() it is drawn immediately
+    void Submit(const TextureRegion &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // Queues prebuilt instance data sampling the given texture
+    void SubmitInstance(unsigned int texture, const SpriteInstance &instance);
+    // Draws all queued sprites and closes the batch
+    void Flush();
+    // Uploads a static set of sprites into a GPU resident buffer (created on first use)
+    void UploadBuffer(SpriteBuffer &buffer, const std::vector<SpriteInstance> &instances);
+    // Overwrites a single instance of a resident buffer
+    void UpdateBuffer(SpriteBuffer &buffer, unsigned int index, const SpriteInstance &instance);
+    // Draws a resident buffer with one instanced draw call (after any queued sprites)
+    void DrawBuffer(const SpriteBuffer &buffer, unsigned int texture);
+    // Number of draw calls issued since construction
+    unsigned int DrawCalls;
 private:
     // Render state
     Shader       shader;
-    unsigned int quadVAO;
+    unsigned int quadVBO, quadVAO;
+    unsigned int instanceVBO;
+    // Batch state
+    std::vector<SpriteInstance> instances;
+    unsigned int                batchTexture;
+    bool                        batching;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData();
+    // Configures a VAO sourcing the quad vertices and per-instance data from the given buffer
+    void initInstanceAttributes(unsigned int VAO, unsigned int instanceVBO);
+    // Sets up all state for an instanced draw call with the given texture
+    void prepareDraw(unsigned int texture);
+    // Draws the queued sprites with a single instanced draw call
+    void drawBatch();
 };
 
 #endif
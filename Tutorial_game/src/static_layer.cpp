@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "static_layer.h"
+#include "gl_state.h"
+
+#include <iostream>
+
+
+StaticLayer::StaticLayer(unsigned int width, unsigned int height)
+    : Texture(), Bakes(0)
+{
+    // the layer is drawn 1:1 onto the scene, so it must not wrap around at the borders
+    this->Texture.Wrap_S = GL_CLAMP_TO_EDGE;
+    this->Texture.Wrap_T = GL_CLAMP_TO_EDGE;
+    this->Texture.Generate(width, height, NULL);
+    glGenFramebuffers(1, &this->FBO);
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Texture.ID, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::STATICLAYER: Failed to initialize FBO" << std::endl;
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+StaticLayer::~StaticLayer()
+{
+    GLState::DeleteFramebuffer(this->FBO);
+    GLState::DeleteTexture(this->Texture.ID);
+}
+
+void StaticLayer::Bake(SpriteRenderer &renderer, const std::vector<StaticSprite> &sprites)
+{
+    // baking happens in the middle of a frame; remember where the scene goes
+    int previousFramebuffer = 0;
+    int viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glViewport(0, 0, this->Texture.Width, this->Texture.Height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    renderer.Begin();
+    for (const StaticSprite &sprite : sprites)
+        renderer.SubmitInstance(sprite.Texture, sprite.Instance);
+    renderer.Flush();
+    this->Bakes++;
+
+    GLState::BindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+TextureRegion StaticLayer::Region() const
+{
+    return TextureRegion(this->Texture.ID, glm::vec4(0.0f, 1.0f, 1.0f, -1.0f));
+}
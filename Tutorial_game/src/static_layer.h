@@ -0,0 +1,45 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STATIC_LAYER_H
+#define STATIC_LAYER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "sprite_renderer.h"
+#include "sprite.h"
+
+
+// StaticLayer caches everything that doesn't change while a level is
+// played (the background and the solid bricks) in a render target.
+// It is re-baked only when its contents change and otherwise drawn as
+// a single screen sized sprite.
+class StaticLayer
+{
+public:
+    // the cached image
+    Texture2D    Texture;
+    // number of times the layer was baked
+    unsigned int Bakes;
+    // constructor (allocates a target of the scene's size)
+    StaticLayer(unsigned int width, unsigned int height);
+    // destructor
+    ~StaticLayer();
+    // renders the given sprites into the layer, replacing its contents
+    void Bake(SpriteRenderer &renderer, const std::vector<StaticSprite> &sprites);
+    // the layer as a sprite region (flipped, as render targets are stored bottom-up)
+    TextureRegion Region() const;
+private:
+    unsigned int FBO;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "swept_collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+bool SweepCircleBox(glm::vec2 center, float radius, glm::vec2 motion, glm::vec2 boxMin, glm::vec2 boxMax, SweptContact &contact)
+{
+    // 1. already overlapping: push out along the way to the closest point (or the nearest face if the center is inside)
+    const glm::vec2 closest = glm::clamp(center, boxMin, boxMax);
+    const glm::vec2 away = center - closest;
+    const float distance2 = glm::dot(away, away);
+    if (distance2 <= radius * radius)
+    {
+        glm::vec2 normal;
+        if (distance2 > 0.0f)
+            normal = away / std::sqrt(distance2);
+        else
+        {
+            const float faces[4] = { center.x - boxMin.x, boxMax.x - center.x, center.y - boxMin.y, boxMax.y - center.y };
+            const glm::vec2 normals[4] = { glm::vec2(-1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, -1.0f), glm::vec2(0.0f, 1.0f) };
+            normal = normals[std::min_element(faces, faces + 4) - faces];
+        }
+        if (glm::dot(motion, normal) >= 0.0f)
+            return false;
+        contact = { 0.0f, normal };
+        return true;
+    }
+
+    // 2. the center's ray against the slabs of the grown box
+    const glm::vec2 grownMin = boxMin - radius, grownMax = boxMax + radius;
+    float enter = -std::numeric_limits<float>::infinity(), leave = std::numeric_limits<float>::infinity();
+    int axis = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (motion[i] == 0.0f)
+        {
+            if (center[i] < grownMin[i] || center[i] > grownMax[i])
+                return false;
+            continue;
+        }
+        float first = (grownMin[i] - center[i]) / motion[i], last = (grownMax[i] - center[i]) / motion[i];
+        if (first > last)
+            std::swap(first, last);
+        if (first > enter)
+        {
+            enter = first;
+            axis = i;
+        }
+        leave = std::min(leave, last);
+    }
+    if (enter > leave || enter > 1.0f || leave < 0.0f)
+        return false;
+    enter = std::max(enter, 0.0f);
+
+    // 3. beyond the box on both axes the grown box is rounded: test the circle around that corner instead
+    const glm::vec2 point = center + motion * enter;
+    const bool outsideX = point.x < boxMin.x || point.x > boxMax.x;
+    const bool outsideY = point.y < boxMin.y || point.y > boxMax.y;
+    if (outsideX && outsideY)
+    {
+        const glm::vec2 corner(point.x < boxMin.x ? boxMin.x : boxMax.x, point.y < boxMin.y ? boxMin.y : boxMax.y);
+        const glm::vec2 offset = center - corner;
+        const float a = glm::dot(motion, motion), b = glm::dot(offset, motion), c = glm::dot(offset, offset) - radius * radius;
+        const float discriminant = b * b - a * c;
+        if (a == 0.0f || discriminant < 0.0f)
+            return false;
+        const float time = (-b - std::sqrt(discriminant)) / a;
+        if (time < 0.0f || time > 1.0f)
+            return false;
+        contact = { time, (center + motion * time - corner) / radius };
+        return true;
+    }
+    glm::vec2 normal(0.0f);
+    normal[axis] = motion[axis] > 0.0f ? -1.0f : 1.0f;
+    contact = { enter, normal };
+    return true;
+}
+
+glm::vec2 Reflect(glm::vec2 velocity, glm::vec2 normal)
+{
+    return velocity - 2.0f * glm::dot(velocity, normal) * normal;
+}
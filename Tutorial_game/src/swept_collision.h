@@ -0,0 +1,32 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SWEPT_COLLISION_H
+#define SWEPT_COLLISION_H
+
+#include <glm/glm.hpp>
+
+
+// Where a moving circle first touches an obstacle
+struct SweptContact {
+    float     Time;   // fraction of the motion travelled at the contact, in [0, 1]
+    glm::vec2 Normal; // unit normal of the obstacle's surface at the contact, pointing at the circle
+};
+
+// Sweeps a circle along motion against an axis aligned box (continuous
+// collision detection, so fast circles can't tunnel through thin boxes).
+// It is the ray test of the circle's center against the box grown by the
+// radius, whose corners are rounded. A circle already overlapping the box
+// touches it at time 0, but only if it moves further in; one moving out
+// (e.g. after bouncing off it) passes.
+bool SweepCircleBox(glm::vec2 center, float radius, glm::vec2 motion, glm::vec2 boxMin, glm::vec2 boxMax, SweptContact &contact);
+
+// Reflects a velocity off a surface with the given unit normal
+glm::vec2 Reflect(glm::vec2 velocity, glm::vec2 normal);
+
+#endif
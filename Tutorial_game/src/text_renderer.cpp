@@ -1,5 +1,3 @@
-
-
 /*******************************************************************
 ** This code is part of Breakout.
 **
@@ -9,37 +7,76 @@
 ** option) any later version.
 ******************************************************************/
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
 #include "text_renderer.h"
 #include "resource_manager.h"
+#include "gl_state.h"
+
+// Width of the glyph atlas texture in pixels
+constexpr int GLYPH_ATLAS_WIDTH = 1024;
+// Empty space between glyphs in the atlas so linear filtering never bleeds
+constexpr int GLYPH_PADDING = 1;
+
+
+// Decodes the UTF-8 sequence starting at text[i] and advances i past it
+static char32_t decodeUTF8(const std::string &text, std::size_t &i)
+{
+    const unsigned char lead = text[i++];
+    int extra = 0;
+    char32_t code = lead;
+    if (lead >= 0xF0)      { extra = 3; code = lead & 0x07; }
+    else if (lead >= 0xE0) { extra = 2; code = lead & 0x0F; }
+    else if (lead >= 0xC0) { extra = 1; code = lead & 0x1F; }
+    for (; extra > 0 && i < text.size(); --extra)
+        code = (code << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+    return code;
+}
 
 
 TextRenderer::TextRenderer(unsigned int width, unsigned int height)
+    : Characters(), Atlas(0), bufferSize(0), ascent(0), sdf(false), ftLibrary(nullptr), ftFace(nullptr), cellSize(0), cellsPerRow(0)
 {
     // load and configure shader
-    this->TextShader = ResourceManager::LoadShader("text_2d.vs", "text_2d.fs", nullptr, "text");
-    this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
+    this->projection = glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
+    this->TextShader = ResourceManager::LoadShader("assets/shaders/text.vert", "assets/shaders/text.frag", nullptr, "text");
+    this->TextShader.SetMatrix4("projection", this->projection, true);
     this->TextShader.SetInteger("text", 0);
-    // configure VAO/VBO for texture quads
+    this->textColorUniform = this->TextShader.GetUniform<glm::vec3>("textColor");
+    // the distance field variant shares the vertex stage
+    this->sdfShader = ResourceManager::LoadShader("assets/shaders/text.vert", "assets/shaders/text_sdf.frag", nullptr, "text_sdf");
+    this->sdfShader.SetMatrix4("projection", this->projection, true);
+    this->sdfShader.SetInteger("text", 0);
+    this->sdfColorUniform = this->sdfShader.GetUniform<glm::vec3>("textColor");
+    // configure VAO/VBO for texture quads; the VBO grows with the longest string rendered
     glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
-    glBindVertexArray(this->VAO);
+    GLState::BindVertexArray(this->VAO);
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+}
+
+TextRenderer::~TextRenderer()
+{
+    this->closeFont();
 }
 
 void TextRenderer::Load(std::string font, unsigned int fontSize)
 {
     // first clear the previously loaded Characters
-    this->Characters.clear();
+    std::fill(std::begin(this->Characters), std::end(this->Characters), Character());
+    if (this->Atlas != 0)
+        GLState::DeleteTexture(this->Atlas);
+    this->closeFont();
+    this->sdf = false;
     // then initialize and load the FreeType library
     FT_Library ft;    
     if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
@@ -50,10 +87,11 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
         std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
     // set size to load glyphs as
     FT_Set_Pixel_Sizes(face, 0, fontSize);
-    // disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-    // then for the first 128 ASCII characters, pre-load/compile their characters and store them
-    for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
+    // then for the first 128 ASCII characters, rasterize them and lay them out row by row in the atlas
+    std::vector<std::vector<unsigned char>> bitmaps(GLYPH_COUNT);
+    std::vector<glm::ivec2> positions(GLYPH_COUNT);
+    int penX = 0, penY = 0, rowHeight = 0;
+    for (unsigned int c = 0; c < GLYPH_COUNT; c++)
     {
         // load character glyph 
         if (FT_Load_Char(face, c, FT_LOAD_RENDER))
@@ -61,82 +99,245 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
             std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
             continue;
         }
-        // generate texture
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-            );
-        // set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-       
-        // now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+        const FT_Bitmap &bitmap = face->glyph->bitmap;
+        const int w = bitmap.width, h = bitmap.rows;
+        if (penX + w + GLYPH_PADDING > GLYPH_ATLAS_WIDTH)
+        {   // start a new row
+            penX = 0;
+            penY += rowHeight + GLYPH_PADDING;
+            rowHeight = 0;
+        }
+        positions[c] = glm::ivec2(penX, penY);
+        penX += w + GLYPH_PADDING;
+        rowHeight = std::max(rowHeight, h);
+        // keep a tightly packed copy of the bitmap (FreeType rows may be padded)
+        bitmaps[c].resize(w * h);
+        for (int row = 0; row < h; ++row)
+            std::memcpy(&bitmaps[c][row * w], bitmap.buffer + row * bitmap.pitch, w);
+        // now store character for later use; UVs are resolved once the atlas height is known
+        this->Characters[c] = {
+            glm::vec4(0.0f),
+            glm::ivec2(w, h),
             glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
+            static_cast<int>(face->glyph->advance.x)
         };
-        Characters.insert(std::pair<char, Character>(c, character));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    const int atlasHeight = std::max(penY + rowHeight, 1);
+    // copy all glyphs into a single image
+    std::vector<unsigned char> pixels(GLYPH_ATLAS_WIDTH * atlasHeight, 0);
+    for (unsigned int c = 0; c < GLYPH_COUNT; c++)
+    {
+        Character &ch = this->Characters[c];
+        for (int row = 0; row < ch.Size.y; ++row)
+            std::memcpy(&pixels[(positions[c].y + row) * GLYPH_ATLAS_WIDTH + positions[c].x], &bitmaps[c][row * ch.Size.x], ch.Size.x);
+        ch.UV = glm::vec4(
+            static_cast<float>(positions[c].x) / GLYPH_ATLAS_WIDTH, static_cast<float>(positions[c].y) / atlasHeight,
+            static_cast<float>(ch.Size.x) / GLYPH_ATLAS_WIDTH, static_cast<float>(ch.Size.y) / atlasHeight);
+    }
+    this->ascent = this->Characters['H'].Bearing.y;
+    // generate texture
+    glGenTextures(1, &this->Atlas);
+    GLState::BindTexture(this->Atlas);
+    // disable byte-alignment restriction
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, GLYPH_ATLAS_WIDTH, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // set texture options
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     // destroy FreeType once we're finished
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
 }
 
+void TextRenderer::LoadSDF(std::string font, unsigned int glyphSize)
+{
+    std::fill(std::begin(this->Characters), std::end(this->Characters), Character());
+    if (this->Atlas != 0)
+        GLState::DeleteTexture(this->Atlas);
+    this->closeFont();
+    this->glyphCache.clear();
+    this->lru.clear();
+    this->freeSlots.clear();
+    this->sdf = true;
+    // keep FreeType open: glyphs are rasterized on first use
+    if (FT_Init_FreeType(&this->ftLibrary))
+    {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return;
+    }
+    const int spread = SDF_SPREAD;
+    FT_Property_Set(this->ftLibrary, "sdf", "spread", &spread);
+    if (FT_New_Face(this->ftLibrary, font.c_str(), 0, &this->ftFace))
+    {
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        this->closeFont();
+        return;
+    }
+    FT_Set_Pixel_Sizes(this->ftFace, 0, glyphSize);
+    // size the cache cells after the largest glyph of the face plus the distance field margin
+    const FT_Size_Metrics &metrics = this->ftFace->size->metrics;
+    const int maxWidth = FT_MulFix(this->ftFace->bbox.xMax - this->ftFace->bbox.xMin, metrics.x_scale) >> 6;
+    const int maxHeight = FT_MulFix(this->ftFace->bbox.yMax - this->ftFace->bbox.yMin, metrics.y_scale) >> 6;
+    this->cellSize = glm::ivec2(maxWidth, maxHeight) + 2 * SDF_SPREAD + 2 * GLYPH_PADDING;
+    this->cellSize = glm::clamp(this->cellSize, glm::ivec2(1), glm::ivec2(SDF_ATLAS_SIZE));
+    this->cellsPerRow = SDF_ATLAS_SIZE / this->cellSize.x;
+    const unsigned int slots = this->cellsPerRow * (SDF_ATLAS_SIZE / this->cellSize.y);
+    for (unsigned int slot = slots; slot > 0; --slot)
+        this->freeSlots.push_back(slot - 1);
+    // create the (empty) cache texture
+    glGenTextures(1, &this->Atlas);
+    GLState::BindTexture(this->Atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SDF_ATLAS_SIZE, SDF_ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // warm up the cache with printable ASCII
+    for (char32_t c = 32; c < GLYPH_COUNT - 1; ++c)
+        this->sdfGlyph(c);
+    const Character *H = this->sdfGlyph('H');
+    this->ascent = H ? H->Bearing.y : 0;
+}
+
 void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color)
 {
-    // activate corresponding render state	
-    this->TextShader.Use();
-    this->TextShader.SetVector3f("textColor", color);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(this->VAO);
-
-    // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+    // build the quads of all characters first
+    this->vertices.clear();
+    this->pendingColor = color;
+    for (std::size_t i = 0; i < text.size(); )
     {
-        Character ch = Characters[*c];
-
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
-
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 0.0f },
-
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f }
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        const Character *ch = nullptr;
+        if (this->sdf)
+            ch = this->sdfGlyph(decodeUTF8(text, i));
+        else
+        {
+            const unsigned char code = static_cast<unsigned char>(text[i++]);
+            if (code < GLYPH_COUNT)
+                ch = &this->Characters[code];
+        }
+        if (!ch)
+            continue;
+        this->addQuad(*ch, x, y, scale);
         // now advance cursors for next glyph
-        x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+        x += (ch->Advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+    }
+    this->flush(color);
+}
+
+void TextRenderer::addQuad(const Character &ch, float x, float y, float scale)
+{
+    const float xpos = x + ch.Bearing.x * scale;
+    const float ypos = y + (this->ascent - ch.Bearing.y) * scale;
+
+    const float w = ch.Size.x * scale;
+    const float h = ch.Size.y * scale;
+    const float u0 = ch.UV.x, v0 = ch.UV.y, u1 = ch.UV.x + ch.UV.z, v1 = ch.UV.y + ch.UV.w;
+    const float quad[6][4] = {
+        { xpos,     ypos + h,   u0, v1 },
+        { xpos + w, ypos,       u1, v0 },
+        { xpos,     ypos,       u0, v0 },
+
+        { xpos,     ypos + h,   u0, v1 },
+        { xpos + w, ypos + h,   u1, v1 },
+        { xpos + w, ypos,       u1, v0 }
+    };
+    this->vertices.insert(this->vertices.end(), &quad[0][0], &quad[0][0] + 6 * 4);
+}
+
+void TextRenderer::flush(glm::vec3 color)
+{
+    if (this->vertices.empty())
+        return;
+    // upload all quads at once, growing (or orphaning) the buffer
+    const unsigned int size = this->vertices.size() * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    this->bufferSize = std::max(this->bufferSize, size);
+    glBufferData(GL_ARRAY_BUFFER, this->bufferSize, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, this->vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // activate corresponding render state and render the whole string
+    if (this->sdf)
+    {
+        this->sdfShader.Use();
+        this->sdfShader.Set(this->sdfColorUniform, color);
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    else
+    {
+        this->TextShader.Use();
+        this->TextShader.Set(this->textColorUniform, color);
+    }
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::BindTexture(this->Atlas, 0);
+    GLState::BindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, this->vertices.size() / 4);
+    this->vertices.clear();
+}
+
+const Character *TextRenderer::sdfGlyph(char32_t code)
+{
+    auto cached = this->glyphCache.find(code);
+    if (cached != this->glyphCache.end())
+    {   // mark as most recently used
+        this->lru.splice(this->lru.begin(), this->lru, cached->second.Use);
+        return &cached->second.Metrics;
+    }
+    if (!this->ftFace)
+        return nullptr;
+    // rasterize the distance field of the glyph
+    if (FT_Load_Char(this->ftFace, code, FT_LOAD_DEFAULT) || FT_Render_Glyph(this->ftFace->glyph, FT_RENDER_MODE_SDF))
+    {
+        std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+        return nullptr;
+    }
+    const FT_GlyphSlot glyph = this->ftFace->glyph;
+    const int w = std::min<int>(glyph->bitmap.width, this->cellSize.x - 2 * GLYPH_PADDING);
+    const int h = std::min<int>(glyph->bitmap.rows, this->cellSize.y - 2 * GLYPH_PADDING);
+    // take a free cell, or evict the least recently used glyph
+    if (this->freeSlots.empty())
+    {
+        // quads of the current string may still sample the evicted cell, so draw them first
+        this->flush(this->pendingColor);
+        const char32_t victim = this->lru.back();
+        this->lru.pop_back();
+        this->freeSlots.push_back(this->glyphCache[victim].Slot);
+        this->glyphCache.erase(victim);
+    }
+    const unsigned int slot = this->freeSlots.back();
+    this->freeSlots.pop_back();
+    const glm::ivec2 cell(slot % this->cellsPerRow * this->cellSize.x, slot / this->cellsPerRow * this->cellSize.y);
+    // upload the whole cell so no leftovers of an evicted glyph remain around the new one
+    std::vector<unsigned char> pixels(this->cellSize.x * this->cellSize.y, 0);
+    for (int row = 0; row < h; ++row)
+        std::memcpy(&pixels[(row + GLYPH_PADDING) * this->cellSize.x + GLYPH_PADDING], glyph->bitmap.buffer + row * glyph->bitmap.pitch, w);
+    GLState::BindTexture(this->Atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, cell.x, cell.y, this->cellSize.x, this->cellSize.y, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    this->lru.push_front(code);
+    CachedGlyph &entry = this->glyphCache[code];
+    entry.Slot = slot;
+    entry.Use = this->lru.begin();
+    entry.Metrics = {
+        glm::vec4(
+            static_cast<float>(cell.x + GLYPH_PADDING) / SDF_ATLAS_SIZE, static_cast<float>(cell.y + GLYPH_PADDING) / SDF_ATLAS_SIZE,
+            static_cast<float>(w) / SDF_ATLAS_SIZE, static_cast<float>(h) / SDF_ATLAS_SIZE),
+        glm::ivec2(w, h),
+        glm::ivec2(glyph->bitmap_left, glyph->bitmap_top),
+        static_cast<int>(glyph->advance.x)
+    };
+    return &entry.Metrics;
+}
+
+void TextRenderer::closeFont()
+{
+    if (this->ftFace)
+        FT_Done_Face(this->ftFace);
+    if (this->ftLibrary)
+        FT_Done_FreeType(this->ftLibrary);
+    this->ftFace = nullptr;
+    this->ftLibrary = nullptr;
 }
@@ -1,5 +1,3 @@
-
-
 /*******************************************************************
 ** This code is part of Breakout.
 **
@@ -11,7 +9,10 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -22,32 +23,85 @@
 
 /// Holds all state information relevant to a character as loaded using FreeType
 struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
+    glm::vec4    UV;        // <vec2 offset, vec2 scale> of the glyph in the glyph atlas
     glm::ivec2   Size;      // size of glyph
     glm::ivec2   Bearing;   // offset from baseline to left/top of glyph
     int          Advance;   // horizontal offset to advance to next glyph
 };
 
+// Number of (ASCII) characters pre-loaded by TextRenderer
+constexpr unsigned int GLYPH_COUNT = 128;
+// Size of the signed distance field glyph cache texture in pixels
+constexpr unsigned int SDF_ATLAS_SIZE = 1024;
+// Distance (in pixels) covered by the signed distance field around each glyph outline
+constexpr int SDF_SPREAD = 8;
+
+// FreeType handles (kept open in SDF mode to rasterize glyphs on demand)
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
 
 // A renderer class for rendering text displayed by a font loaded using the 
 // FreeType library. A single font is loaded, processed into a list of Character
-// items for later rendering.
+// items for later rendering. All glyphs are rasterized into one atlas
+// texture, so a whole string is rendered with a single draw call.
+// Alternatively LoadSDF() rasterizes glyphs once as signed distance
+// fields that stay crisp at any scale. In that mode any Unicode glyph
+// is inserted into the atlas on first use (text is UTF-8) and the
+// least recently used glyphs are evicted when the atlas is full.
 class TextRenderer
 {
 public:
-    // holds a list of pre-compiled Characters
-    std::map<char, Character> Characters; 
+    // holds a list of pre-compiled Characters, indexed by character code
+    Character Characters[GLYPH_COUNT];
+    // atlas texture holding all glyph bitmaps
+    unsigned int Atlas;
     // shader used for text rendering
     Shader TextShader;
-    // constructor
+    // constructor/destructor
     TextRenderer(unsigned int width, unsigned int height);
+    ~TextRenderer();
     // pre-compiles a list of characters from the given font
     void Load(std::string font, unsigned int fontSize);
+    // switches to distance field glyphs rasterized at the given size; scale in RenderText is relative to it
+    void LoadSDF(std::string font, unsigned int glyphSize);
     // renders a string of text using the precompiled list of characters
     void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
 private:
+    // a glyph resident in the distance field cache
+    struct CachedGlyph {
+        Character                     Metrics;
+        unsigned int                  Slot;
+        std::list<char32_t>::iterator Use; // position in the LRU list
+    };
     // render state
     unsigned int VAO, VBO;
+    unsigned int bufferSize; // capacity of VBO in bytes
+    std::vector<float> vertices;
+    glm::mat4 projection;
+    glm::vec3 pendingColor; // color of the string currently being built
+    Uniform<glm::vec3> textColorUniform;
+    // distance from the top of a line to the baseline (bearing of 'H')
+    int ascent;
+    // distance field state
+    bool                                     sdf;
+    Shader                                   sdfShader;
+    Uniform<glm::vec3>                       sdfColorUniform;
+    FT_LibraryRec_                          *ftLibrary;
+    FT_FaceRec_                             *ftFace;
+    glm::ivec2                               cellSize;
+    unsigned int                             cellsPerRow;
+    std::unordered_map<char32_t, CachedGlyph> glyphCache;
+    std::list<char32_t>                      lru;       // most recently used glyph first
+    std::vector<unsigned int>                freeSlots;
+    // returns a glyph of the distance field cache, rasterizing it (and evicting others) if needed
+    const Character *sdfGlyph(char32_t code);
+    // appends the quad of a glyph to the pending vertices
+    void addQuad(const Character &ch, float x, float y, float scale);
+    // draws and clears the pending vertices
+    void flush(glm::vec3 color);
+    // releases the FreeType face/library kept open in SDF mode
+    void closeFont();
 };
 
 #endif 
@@ -10,6 +10,9 @@
 #define TEXTURE_H
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "sprite.h"
 
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
@@ -32,8 +35,10 @@ public:
     Texture2D();
     // generates texture from image data
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
-    // binds the texture as the current active GL_TEXTURE_2D texture object
-    void Bind() const;
+    // binds the texture as the GL_TEXTURE_2D texture object of the given texture unit
+    void Bind(unsigned int unit = 0) const;
+    // the whole texture as a sprite region
+    operator TextureRegion() const { return TextureRegion(this->ID, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)); }
 };
 
 #endif
@@ -0,0 +1,96 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "worker_pool.h"
+
+#include <algorithm>
+
+
+WorkerPool::WorkerPool()
+    : workers(), generation(0), quit(false), job(nullptr), jobCount(0), finishedWorkers(0), nextItem(0)
+{
+
+}
+
+WorkerPool::~WorkerPool()
+{
+    this->stop();
+}
+
+void WorkerPool::Start(unsigned int threads)
+{
+    this->stop();
+    const unsigned int count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < count; ++i)
+        this->workers.emplace_back(&WorkerPool::workerLoop, this, this->generation);
+}
+
+unsigned int WorkerPool::ThreadCount() const
+{
+    return static_cast<unsigned int>(this->workers.size()) + 1;
+}
+
+void WorkerPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)> &job)
+{
+    if (this->workers.empty())
+    {
+        for (unsigned int item = 0; item < count; ++item)
+            job(item);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->job = &job;
+        this->jobCount = count;
+        this->nextItem = 0;
+        this->finishedWorkers = 0;
+        this->generation++;
+    }
+    this->wake.notify_all();
+    this->runItems();
+    // every worker takes part in every job, so once all of them are through every item is finished
+    // (and none of them can still be reading the job when the next one is set up)
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this] { return this->finishedWorkers == this->workers.size(); });
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->quit = true;
+    }
+    this->wake.notify_all();
+    for (std::thread &worker : this->workers)
+        worker.join();
+    this->workers.clear();
+    this->quit = false;
+}
+
+void WorkerPool::runItems()
+{
+    for (unsigned int item = this->nextItem++; item < this->jobCount; item = this->nextItem++)
+        (*this->job)(item);
+}
+
+void WorkerPool::workerLoop(unsigned int seen)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->wake.wait(lock, [this, &seen] { return this->quit || this->generation != seen; });
+        if (this->quit)
+            return;
+        seen = this->generation;
+        lock.unlock();
+        this->runItems();
+        lock.lock();
+        if (++this->finishedWorkers == this->workers.size())
+            this->done.notify_all();
+    }
+}
@@ -0,0 +1,56 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// WorkerPool runs the items of a job on a fixed set of threads: the
+// caller of ParallelFor and the workers started beforehand each take
+// the next unclaimed item until none are left. Items can finish in any
+// order, so a job has to give the same result whichever thread runs an
+// item. Before Start (or with a single thread) the caller runs them all.
+class WorkerPool
+{
+public:
+    // constructor/destructor (stops the workers)
+    WorkerPool();
+    ~WorkerPool();
+    // (re)starts the workers: threads - 1 of them, the caller of ParallelFor being the last one (0: one per hardware thread)
+    void Start(unsigned int threads);
+    // threads taking part in a job, the caller included
+    unsigned int ThreadCount() const;
+    // runs the job for the indices [0, count) on all threads and waits for it
+    void ParallelFor(unsigned int count, const std::function<void(unsigned int)> &job);
+private:
+    // the caller of ParallelFor works along
+    std::vector<std::thread> workers;
+    std::mutex               mutex;
+    std::condition_variable  wake, done;
+    unsigned int             generation;
+    bool                     quit;
+    const std::function<void(unsigned int)> *job;
+    unsigned int             jobCount;
+    unsigned int             finishedWorkers; // workers through with the current job
+    std::atomic<unsigned int> nextItem;
+    // joins the workers
+    void stop();
+    // takes items of the current job until none are left
+    void runItems();
+    // waits for jobs newer than the generation seen
+    void workerLoop(unsigned int seen);
+};
+
+#endif